@@ -0,0 +1,623 @@
+#define _POSIX_C_SOURCE 200809L
+
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <glib.h>
+
+#include <libsnps/snps.h>
+
+/* a named set of games of the same shape */
+typedef struct {
+    const char *name;
+    snps_game_t **games;
+    unsigned count;
+} bench_corpus_t;
+
+/* the measurements of a game, the fastest of all repeats */
+typedef struct {
+    snps_status_t status;
+    unsigned length;
+    double seconds;
+    unsigned compared;
+    unsigned expanded;
+    snps_profile_t profile;
+} bench_sample_t;
+
+typedef struct {
+    const char *name;
+    snps_algorithm_t algorithm;
+} bench_algorithm_t;
+
+/* how the benchmark runs */
+typedef struct {
+    unsigned count;
+    unsigned warmup;
+    unsigned repeats;
+    unsigned walk;
+    unsigned perimeter;
+    /* the directory of the tables of exact distances, NULL to search */
+    const char *tables;
+    guint32 seed;
+    unsigned long long states;
+    size_t memory;
+    const char *input;
+    int csv;
+    /* solve every game again with these vector instructions and compare the
+       results, -1 skips the check */
+    int check;
+} bench_settings_t;
+
+static const bench_algorithm_t algorithms[] = {
+    {"optimal", SNPS_ALGORITHM_OPTIMAL},
+    {"fast", SNPS_ALGORITHM_FAST},
+    {"ida", SNPS_ALGORITHM_IDA},
+    {"ida-parallel", SNPS_ALGORITHM_IDA_PARALLEL},
+    {"bidirectional", SNPS_ALGORITHM_BIDIRECTIONAL},
+    {"anytime", SNPS_ALGORITHM_ANYTIME},
+    {"fast-parallel", SNPS_ALGORITHM_FAST_PARALLEL},
+    {"decompose", SNPS_ALGORITHM_DECOMPOSE},
+};
+
+static const char *statuses[] = {
+    "solved", "unsolvable", "exhausted", "cancelled",
+};
+
+static const char *simds[] = {
+    "scalar", "sse4", "avx2",
+};
+
+/* prototypes */
+static int bench_corpus_load(bench_corpus_t *corpus, const char *name,
+    const bench_settings_t *settings);
+static snps_game_t *bench_game_parse(char *line);
+static void bench_corpus_walk(bench_corpus_t *corpus, unsigned rows,
+    unsigned columns, const bench_settings_t *settings);
+static void bench_corpus_free(bench_corpus_t *corpus);
+static snps_table_t *bench_table(const bench_corpus_t *corpus,
+    const char *directory);
+static void bench_sample(snps_solver_t *solver, snps_game_t *game,
+    snps_algorithm_t algorithm, const bench_settings_t *settings,
+    bench_sample_t *sample);
+static void bench_report(const bench_corpus_t *corpus, const char *algorithm,
+    const bench_sample_t *samples, long rss, const bench_settings_t *settings,
+    int first);
+static unsigned bench_check(snps_solver_t *solver,
+    const bench_corpus_t *corpus, const bench_algorithm_t *algorithm,
+    const bench_sample_t *samples, const bench_settings_t *settings);
+static int bench_compare(const void *a, const void *b);
+static void bench_rss_reset(void);
+static long bench_rss_peak(void);
+
+/* run every solver on a number of corpora and report the results as JSON or
+   CSV */
+int main(int argc, const char *argv[])
+{
+    const char *corpora = "demo2,3x3,4x4,5x5";
+    const char *names = NULL;
+    bench_settings_t settings = {
+        .count = 10,
+        .warmup = 1,
+        .repeats = 3,
+        .walk = 0,
+        .perimeter = 0,
+        .tables = NULL,
+        .seed = 42,
+        .states = 20000000,
+        .memory = 1024,
+        .input = "data/demo2.in",
+        .csv = 0,
+        .check = -1,
+    };
+    unsigned mismatches = 0;
+
+    /* usage: bench [-c CORPORA] [-a ALGORITHMS] [-n COUNT] [-w WARMUP]
+       [-r REPEATS] [-l WALK] [-p DEPTH] [-e DIRECTORY] [-s SEED]
+       [-b STATES] [-m MEGABYTES] [-i FILE] [-f json|csv]
+       [-x scalar|sse4|avx2] */
+    for (int i = 1; i < argc; ++i) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (value == NULL || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            fprintf(stderr, "Usage: %s [-c CORPORA] [-a ALGORITHMS] "
+                "[-n COUNT] [-w WARMUP] [-r REPEATS] [-l WALK] [-p DEPTH] "
+                "[-e DIRECTORY] [-s SEED] [-b STATES] [-m MEGABYTES] "
+                "[-i FILE] [-f json|csv] [-x scalar|sse4|avx2]\n",
+                argv[0]);
+            return 1;
+        }
+
+        switch (argv[i++][1]) {
+            case 'c': corpora = value; break;
+            case 'a': names = value; break;
+            case 'n': settings.count = atoi(value); break;
+            case 'w': settings.warmup = atoi(value); break;
+            case 'r': settings.repeats = MAX(atoi(value), 1); break;
+            case 'l': settings.walk = atoi(value); break;
+            case 'p': settings.perimeter = atoi(value); break;
+            case 'e': settings.tables = value; break;
+            case 's': settings.seed = strtoul(value, NULL, 10); break;
+            case 'b': settings.states = strtoull(value, NULL, 10); break;
+            case 'm': settings.memory = strtoul(value, NULL, 10); break;
+            case 'i': settings.input = value; break;
+            case 'f': settings.csv = strcmp(value, "csv") == 0; break;
+            case 'x':
+                for (int j = 0; j < G_N_ELEMENTS(simds); ++j)
+                    if (strcmp(simds[j], value) == 0)
+                        settings.check = j;
+                if (settings.check < 0) {
+                    fprintf(stderr, "Unknown instructions %s\n", value);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+                return 1;
+        }
+    }
+
+    gchar **corpus_names = g_strsplit(corpora, ",", 0);
+    gchar **algorithm_names = g_strsplit(names != NULL ? names :
+        "optimal,fast,ida,ida-parallel,bidirectional,anytime,fast-parallel",
+        ",", 0);
+    int first = 1;
+
+    if (settings.csv) {
+        printf("instance,corpus,algorithm,index,status,length,seconds,"
+            "compared,expanded\n");
+        printf("summary,corpus,algorithm,count,solved,p50,p90,p99,max,"
+            "expanded_per_second,peak_rss_kb,mean_length\n");
+    } else {
+        printf("{\n  \"warmup\": %u,\n  \"repeats\": %u,\n  \"seed\": %u,\n"
+            "  \"states\": %llu,\n  \"perimeter\": %u,\n  \"simd\": \"%s\",\n"
+            "  \"runs\": [", settings.warmup, settings.repeats, settings.seed,
+            settings.states, settings.perimeter, simds[snps_simd_level()]);
+    }
+
+    for (int i = 0; corpus_names[i] != NULL; ++i) {
+        bench_corpus_t corpus;
+
+        if (bench_corpus_load(&corpus, corpus_names[i], &settings) != 0) {
+            fprintf(stderr, "Unable to load corpus %s\n", corpus_names[i]);
+            continue;
+        }
+
+        /* the games of a corpus share their goal board and so the table */
+        for (int j = 0; j < corpus.count; ++j)
+            snps_game_set_perimeter(corpus.games[j], settings.perimeter);
+
+        snps_table_t *table = settings.tables != NULL ?
+            bench_table(&corpus, settings.tables) : NULL;
+        for (int j = 0; j < corpus.count; ++j)
+            snps_game_set_table(corpus.games[j], table);
+
+        for (int j = 0; algorithm_names[j] != NULL; ++j) {
+            const bench_algorithm_t *algorithm = NULL;
+
+            for (int k = 0; k < G_N_ELEMENTS(algorithms); ++k)
+                if (strcmp(algorithms[k].name, algorithm_names[j]) == 0)
+                    algorithm = &algorithms[k];
+
+            if (algorithm == NULL) {
+                fprintf(stderr, "Unknown algorithm %s\n", algorithm_names[j]);
+                continue;
+            }
+
+            fprintf(stderr, "%s: %s ...\n", corpus.name, algorithm->name);
+
+            snps_solver_t *solver = snps_solver_new();
+            bench_sample_t *samples = g_new0(bench_sample_t,
+                MAX(corpus.count, 1));
+
+            /* the first games warm up the caches and the solver */
+            for (int k = 0; k < MIN(settings.warmup, corpus.count); ++k)
+                bench_sample(solver, corpus.games[k], algorithm->algorithm,
+                    &settings, &samples[k]);
+
+            bench_rss_reset();
+
+            for (int k = 0; k < corpus.count; ++k)
+                bench_sample(solver, corpus.games[k], algorithm->algorithm,
+                    &settings, &samples[k]);
+
+            bench_report(&corpus, algorithm->name, samples, bench_rss_peak(),
+                &settings, first);
+            first = 0;
+
+            if (settings.check >= 0)
+                mismatches += bench_check(solver, &corpus, algorithm,
+                    samples, &settings);
+
+            g_free(samples);
+            snps_solver_free(solver);
+        }
+
+        bench_corpus_free(&corpus);
+        if (table != NULL)
+            snps_table_free(table);
+    }
+
+    if (settings.csv == 0)
+        printf("\n  ]\n}\n");
+
+    g_strfreev(algorithm_names);
+    g_strfreev(corpus_names);
+
+    if (settings.check >= 0)
+        fprintf(stderr, "%u results differ using %s\n", mismatches,
+            simds[settings.check]);
+
+    return mismatches != 0;
+}
+
+/* read the first games of the demo2 input or of another file of games or
+   generate games of the given shape, returns 0 on success */
+static int bench_corpus_load(bench_corpus_t *corpus, const char *name,
+    const bench_settings_t *settings)
+{
+    unsigned rows, columns;
+
+    corpus->name = name;
+    corpus->games = NULL;
+    corpus->count = 0;
+
+    if (sscanf(name, "%ux%u", &rows, &columns) == 2) {
+        if (rows * columns < 2 || rows * columns > SNPS_SIZE_MAX)
+            return 1;
+
+        bench_corpus_walk(corpus, rows, columns, settings);
+        return 0;
+    }
+
+    /* any other corpus is a file of games like data/demo2.in or those
+       written by generate */
+    FILE *file = fopen(strcmp(name, "demo2") == 0 ? settings->input : name,
+        "r");
+    char buffer[4096];
+
+    if (file == NULL)
+        return 1;
+
+    corpus->games = g_new(snps_game_t *, MAX(settings->count, 1));
+
+    while (corpus->count < settings->count &&
+        fgets(buffer, sizeof(buffer), file) != NULL) {
+        snps_game_t *game = bench_game_parse(buffer);
+
+        if (game != NULL)
+            corpus->games[corpus->count++] = game;
+    }
+
+    fclose(file);
+
+    return 0;
+}
+
+/* parse a line of a file of games, either a hex digit per tile of a 4x4
+   board or the size, from and to keys of the lines written by generate,
+   NULL for other lines */
+static snps_game_t *bench_game_parse(char *line)
+{
+    unsigned rows = 4, columns = 4;
+    const char *from = NULL, *to = NULL;
+    char *saved, *token;
+
+    line[strcspn(line, "#")] = '\0';
+
+    for (token = strtok_r(line, " \t\r\n", &saved); token != NULL;
+        token = strtok_r(NULL, " \t\r\n", &saved)) {
+        if (strncmp(token, "size=", 5) == 0) {
+            if (sscanf(token + 5, "%ux%u", &rows, &columns) != 2)
+                return NULL;
+        } else if (strncmp(token, "from=", 5) == 0) {
+            from = token + 5;
+        } else if (strncmp(token, "to=", 3) == 0) {
+            to = token + 3;
+        } else if (strchr(token, '=') == NULL) {
+            from = token;
+        }
+    }
+
+    if (from == NULL || rows * columns < 2 || rows * columns > SNPS_SIZE_MAX)
+        return NULL;
+
+    unsigned size = rows * columns;
+    unsigned char start[size], goal[size];
+
+    for (int i = 0; i < size; ++i)
+        goal[i] = (i + 1) % size;
+
+    if (snps_board_parse(from, size, start) != 0 ||
+        (to != NULL && snps_board_parse(to, size, goal) != 0))
+        return NULL;
+
+    return snps_game_new(rows, columns, start, goal);
+}
+
+/* generate games by random walks of the blank from the ordered board, which
+   never undo their last move, the same seed yields the same games */
+static void bench_corpus_walk(bench_corpus_t *corpus, unsigned rows,
+    unsigned columns, const bench_settings_t *settings)
+{
+    unsigned size = rows * columns;
+    unsigned walk = settings->walk != 0 ? settings->walk : 3 * size;
+    snps_generator_t *generator = snps_generator_new(rows, columns, NULL,
+        settings->seed);
+
+    corpus->games = g_new(snps_game_t *, MAX(settings->count, 1));
+
+    for (int i = 0; i < settings->count; ++i)
+        corpus->games[corpus->count++] = snps_generator_walk(generator,
+            walk);
+
+    snps_generator_free(generator);
+}
+
+static void bench_corpus_free(bench_corpus_t *corpus)
+{
+    for (int i = 0; i < corpus->count; ++i)
+        snps_game_free(corpus->games[i]);
+    g_free(corpus->games);
+}
+
+/* load the table of exact distances of a corpus of small boards from a
+   directory, it's built and saved there on first use */
+static snps_table_t *bench_table(const bench_corpus_t *corpus,
+    const char *directory)
+{
+    if (corpus->count == 0 || corpus->games[0]->size > 12)
+        return NULL;
+
+    gchar *name = g_strdup_printf("%s.table", corpus->name);
+    gchar *filename = g_build_filename(directory, name, NULL);
+    snps_table_t *table = snps_table_load(corpus->games[0], filename);
+
+    if (table == NULL) {
+        fprintf(stderr, "Building table %s ...\n", filename);
+        table = snps_table_build(corpus->games[0]);
+        if (table != NULL && snps_table_save(table, filename) != 0)
+            fprintf(stderr, "Unable to save %s\n", filename);
+    }
+
+    g_free(filename);
+    g_free(name);
+
+    return table;
+}
+
+/* solve a game a number of times and keep the fastest run */
+static void bench_sample(snps_solver_t *solver, snps_game_t *game,
+    snps_algorithm_t algorithm, const bench_settings_t *settings,
+    bench_sample_t *sample)
+{
+    snps_options_t options = {
+        .algorithm = algorithm,
+        .states = settings->states,
+        .solver = solver,
+    };
+
+    snps_game_set_memory_limit(game, settings->memory * 1024 * 1024);
+
+    for (int i = 0; i < settings->repeats; ++i) {
+        snps_result_t result;
+
+        snps_solve_with(game, &options, &result);
+
+        if (i == 0 || result.stats.seconds < sample->seconds) {
+            sample->status = result.status;
+            sample->length = result.route != NULL ?
+                result.route->length - 1 : 0;
+            sample->seconds = result.stats.seconds;
+            sample->compared = result.stats.compared;
+            sample->expanded = result.stats.expanded;
+            sample->profile = result.stats.profile;
+        }
+
+        if (result.route != NULL)
+            snps_route_free(result.route);
+    }
+}
+
+/* solve the games of a corpus once more using other vector instructions,
+   which have to yield the same results, the parallel iterative deepening
+   search only has to find a route of the same length as its threads split
+   the work differently and the parallel fast search any route as its
+   threads race each other, returns the number of games with different
+   results */
+static unsigned bench_check(snps_solver_t *solver,
+    const bench_corpus_t *corpus, const bench_algorithm_t *algorithm,
+    const bench_sample_t *samples, const bench_settings_t *settings)
+{
+    bench_settings_t once = *settings;
+    snps_simd_t simd = snps_simd_level();
+    unsigned mismatches = 0;
+
+    once.repeats = 1;
+    snps_simd_limit(settings->check);
+
+    for (int i = 0; i < corpus->count; ++i) {
+        bench_sample_t sample;
+
+        bench_sample(solver, corpus->games[i], algorithm->algorithm, &once,
+            &sample);
+
+        if (algorithm->algorithm == SNPS_ALGORITHM_FAST_PARALLEL ?
+            sample.status != samples[i].status :
+            sample.status != samples[i].status ||
+            sample.length != samples[i].length ||
+            (algorithm->algorithm != SNPS_ALGORITHM_IDA_PARALLEL &&
+            (sample.compared != samples[i].compared ||
+            sample.expanded != samples[i].expanded))) {
+            fprintf(stderr, "%s: %s game %d differs using %s\n",
+                corpus->name, algorithm->name, i, simds[settings->check]);
+            ++mismatches;
+        }
+    }
+
+    snps_simd_limit(simd);
+
+    return mismatches;
+}
+
+/* print the samples of a solver on a corpus along with the percentiles of
+   their times */
+static void bench_report(const bench_corpus_t *corpus, const char *algorithm,
+    const bench_sample_t *samples, long rss, const bench_settings_t *settings,
+    int first)
+{
+    double times[MAX(corpus->count, 1)], seconds = 0, percentiles[4] = {0};
+    static const double ranks[] = {0.5, 0.9, 0.99, 1.0};
+    unsigned long long expanded = 0, length = 0;
+    unsigned solved = 0;
+    snps_profile_t profile = {0};
+
+    for (int i = 0; i < corpus->count; ++i) {
+        const snps_profile_t *other = &samples[i].profile;
+
+        times[i] = samples[i].seconds;
+        seconds += samples[i].seconds;
+        expanded += samples[i].expanded;
+
+        profile.probes += other->probes;
+        profile.collisions += other->collisions;
+        profile.duplicates += other->duplicates;
+        profile.pushes += other->pushes;
+        profile.pops += other->pops;
+        profile.open_peak = MAX(profile.open_peak, other->open_peak);
+        profile.closed_peak = MAX(profile.closed_peak, other->closed_peak);
+        profile.bytes = MAX(profile.bytes, other->bytes);
+        profile.estimates += other->estimates;
+        profile.expand_seconds += other->expand_seconds;
+        profile.estimate_seconds += other->estimate_seconds;
+        profile.route_seconds += other->route_seconds;
+
+        if (samples[i].status == SNPS_STATUS_SOLVED) {
+            length += samples[i].length;
+            ++solved;
+        }
+    }
+
+    /* the nearest rank of every percentile */
+    qsort(times, corpus->count, sizeof(double), bench_compare);
+    for (int i = 0; i < 4 && corpus->count > 0; ++i)
+        percentiles[i] = times[MAX((unsigned) (ranks[i] * corpus->count +
+            0.999999), 1) - 1];
+
+    double rate = seconds > 0 ? expanded / seconds : 0;
+    double mean = solved > 0 ? (double) length / solved : 0;
+
+    if (settings->csv) {
+        for (int i = 0; i < corpus->count; ++i)
+            printf("instance,%s,%s,%i,%s,%u,%.6f,%u,%u\n", corpus->name,
+                algorithm, i + 1, statuses[samples[i].status],
+                samples[i].length, samples[i].seconds, samples[i].compared,
+                samples[i].expanded);
+
+        printf("summary,%s,%s,%u,%u,%.6f,%.6f,%.6f,%.6f,%.0f,%li,%.2f\n",
+            corpus->name, algorithm, corpus->count, solved, percentiles[0],
+            percentiles[1], percentiles[2], percentiles[3], rate, rss, mean);
+
+        return;
+    }
+
+    printf("%s\n    {\n      \"corpus\": \"%s\",\n"
+        "      \"algorithm\": \"%s\",\n      \"count\": %u,\n"
+        "      \"solved\": %u,\n      \"p50\": %.6f,\n"
+        "      \"p90\": %.6f,\n      \"p99\": %.6f,\n      \"max\": %.6f,\n"
+        "      \"expanded_per_second\": %.0f,\n      \"peak_rss_kb\": %li,\n"
+        "      \"mean_length\": %.2f,\n", first ? "" : ",", corpus->name,
+        algorithm, corpus->count, solved, percentiles[0], percentiles[1],
+        percentiles[2], percentiles[3], rate, rss, mean);
+
+    /* all zero unless the library was built with SNPS_PROFILE */
+    printf("      \"profile\": {\"probes\": %llu, \"collisions\": %llu, "
+        "\"duplicates\": %llu, \"pushes\": %llu, \"pops\": %llu, "
+        "\"open_peak\": %llu, \"closed_peak\": %llu, \"bytes\": %llu, "
+        "\"estimates\": %llu, \"expand_seconds\": %.6f, "
+        "\"estimate_seconds\": %.6f, \"route_seconds\": %.6f},\n"
+        "      \"instances\": [", profile.probes, profile.collisions,
+        profile.duplicates, profile.pushes, profile.pops, profile.open_peak,
+        profile.closed_peak, profile.bytes, profile.estimates,
+        profile.expand_seconds, profile.estimate_seconds,
+        profile.route_seconds);
+
+    for (int i = 0; i < corpus->count; ++i)
+        printf("%s\n        {\"index\": %i, \"status\": \"%s\", "
+            "\"length\": %u, \"seconds\": %.6f, \"compared\": %u, "
+            "\"expanded\": %u}", i == 0 ? "" : ",", i + 1,
+            statuses[samples[i].status], samples[i].length,
+            samples[i].seconds, samples[i].compared, samples[i].expanded);
+
+    printf("\n      ]\n    }");
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* let the peak resident memory start over from the current one, which only
+   works on linux */
+static void bench_rss_reset(void)
+{
+    FILE *file = fopen("/proc/self/clear_refs", "w");
+
+    if (file != NULL) {
+        fputs("5", file);
+        fclose(file);
+    }
+}
+
+/* the peak resident memory in kilobytes since the last reset, or of the whole
+   process where it can't be reset */
+static long bench_rss_peak(void)
+{
+    FILE *file = fopen("/proc/self/status", "r");
+    char line[256];
+    long kilobytes = -1;
+
+    if (file != NULL) {
+        while (kilobytes < 0 && fgets(line, 256, file) != NULL)
+            if (sscanf(line, "VmHWM: %li", &kilobytes) != 1)
+                kilobytes = -1;
+        fclose(file);
+    }
+
+    if (kilobytes < 0) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        kilobytes = usage.ru_maxrss;
+    }
+
+    return kilobytes;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -44,7 +44,11 @@ int main(int argc, char *argv[])
 
     printf("Board dimensions as COLSxROWS:\n");
     fgets(buffer1, 128, stdin);
-    sscanf(buffer1, "%ux%u", &cols, &rows);
+    if (sscanf(buffer1, "%ux%u", &cols, &rows) != 2 || rows * cols < 2 ||
+        rows * cols > SNPS_SIZE_MAX) {
+        printf("\nBoards have between 2 and %u cells!\n", SNPS_SIZE_MAX);
+        return 1;
+    }
 
     unsigned char from[rows * cols];
     unsigned char to[rows * cols];
@@ -76,11 +80,13 @@ int main(int argc, char *argv[])
         p2 = p2_n + 1;
     }
 
-    printf("\nSearch algorithm (0: optimal path, 1: fast search):\n");
+    printf("\nSearch algorithm (0: optimal path, 1: fast search, "
+        "2: optimal path using iterative deepening):\n");
     fgets(buffer1, 128, stdin);
     sscanf(buffer1, "%u", &algorithm);
     
     snps_game_t *game = snps_game_new(rows, cols, from, to);
+    snps_game_set_route_format(game, SNPS_ROUTE_MOVES | SNPS_ROUTE_BOARDS);
     snps_route_t *route = NULL;
 
     struct timeval ts, te;
@@ -90,6 +96,10 @@ int main(int argc, char *argv[])
         printf("\nUsing a breadth first search with pruning to find the "
             "optimal route:\n");
         route = snps_solve_optimal(game, show_stats);
+    } else if (algorithm == 2) {
+        printf("\nUsing an iterative deepening A* search to find the "
+            "optimal route:\n");
+        route = snps_solve_ida(game, show_stats);
     } else {
         printf("\nUsing a heuristic based tree search to find a path fast:\n");
         route = snps_solve_fast(game, show_stats);
@@ -160,7 +170,7 @@ static void show_boards(snps_game_t *game, snps_route_t *route)
                 }
                 printf("│");
                 for (int column = 0; column < game->columns; ++column) {
-                    int p1 = TRANSLATE_2D_TO_1D(row, column, game->rows);
+                    int p1 = TRANSLATE_2D_TO_1D(row, column, game->columns);
                     putchar(' ');
                     if (route->boards[j][p1] == 0)
                         for (int i = 0; i < char_width; ++i)
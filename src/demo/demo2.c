@@ -24,22 +24,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdio.h>
+#include <string.h>
 #include <sys/time.h>
 
 #include <libsnps/snps.h>
 
-static int statesc = 0, statese = 0;
-static long long total_statesc = 0, total_statese = 0;
-static double total_time = 0;
-static long long total_length = 0;
-
-static void show_stats(unsigned states_c, unsigned states_e, unsigned depth)
-{
-    statesc = states_c;
-    statese = states_e;
-}
-
 int main(int argc, const char *argv[])
 {
     char buffer[1024];
@@ -47,7 +36,32 @@ int main(int argc, const char *argv[])
     unsigned char to[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
         0};
     struct timeval ts, te;
-    int i = 0;
+    int count = 0, capacity = 0;
+    unsigned threads = 1;
+    const char *pdb_file = NULL;
+    snps_pdb_t *pdb = NULL;
+    snps_game_t **games = NULL;
+
+    /* usage: demo2 [-t THREADS] [PDB-FILE], 0 threads uses all processors */
+    for (int i = 1; i < argc; ++i)
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else
+            pdb_file = argv[i];
+
+    /* an optional pattern database file, which is built on first use */
+    if (pdb_file != NULL) {
+        snps_game_t *goal = snps_game_new(4, 4, to, to);
+
+        if ((pdb = snps_pdb_load(goal, pdb_file)) == NULL) {
+            fprintf(stderr, "Building pattern database %s ...\n", pdb_file);
+            pdb = snps_pdb_build(goal, NULL);
+            if (snps_pdb_save(pdb, pdb_file) != 0)
+                fprintf(stderr, "Unable to save %s\n", pdb_file);
+        }
+
+        snps_game_free(goal);
+    }
 
     while (fgets(buffer, 1024, stdin) != NULL) {
         for (int i = 0; i < 16; ++i)
@@ -55,39 +69,62 @@ int main(int argc, const char *argv[])
                 from[i] = buffer[i] - '0';
             else
                 from[i] = buffer[i] - 'A' + 10;
-        
-        snps_game_t *game = snps_game_new(4, 4, from, to);
 
-        gettimeofday(&ts, NULL);
-        snps_route_t *route = snps_solve_fast(game, show_stats);
-        gettimeofday(&te, NULL);
+        if (count == capacity) {
+            capacity = capacity == 0 ? 1024 : 2 * capacity;
+            games = realloc(games, capacity * sizeof(snps_game_t *));
+        }
 
-        printf("%04i: ", ++i);
+        games[count] = snps_game_new(4, 4, from, to);
+        snps_game_set_pdb(games[count++], pdb);
+    }
+
+    snps_result_t *results = calloc(count, sizeof(snps_result_t));
+
+    gettimeofday(&ts, NULL);
+    snps_solve_batch(games, count, SNPS_ALGORITHM_FAST, threads, results);
+    gettimeofday(&te, NULL);
+
+    long long total_statesc = 0, total_statese = 0, total_length = 0;
+    double total_time = 0;
+
+    for (int i = 0; i < count; ++i) {
+        snps_route_t *route = results[i].route;
+        snps_stats_t *stats = &results[i].stats;
+
+        printf("%04i: ", i + 1);
 
         if (route == NULL) {
             printf("Not solvable!\n");
         } else {
-            float diff = (float) (te.tv_sec - ts.tv_sec) + (te.tv_usec -
-                ts.tv_usec) / 1000000.0;
-
             printf("Solved: Path Length = %i ; Time = %.4fs ; "
-                "States = %i/%i\n", route->length, diff, statesc, statese);
+                "States = %i/%i\n", route->length, stats->seconds,
+                stats->compared, stats->expanded);
 
-            total_time += diff;
+            total_time += stats->seconds;
             total_length += route->length;
-            total_statesc += statesc;
-            total_statese += statese;
-        }
+            total_statesc += stats->compared;
+            total_statese += stats->expanded;
 
-        if (route != NULL)
             snps_route_free(route);
-        snps_game_free(game);
+        }
+
+        snps_game_free(games[i]);
     }
 
-    printf("\nMean: Path Length = %lli ; Time = %.4fs ; States = %lli/%lli\n",
-        total_length/i, total_time/(double)i, total_statesc/i, total_statese/i);
-    printf("Total Time = %.4fs\n", total_time);
+    if (count > 0)
+        printf("\nMean: Path Length = %lli ; Time = %.4fs ; "
+            "States = %lli/%lli\n", total_length/count,
+            total_time/(double)count, total_statesc/count,
+            total_statese/count);
+    printf("Total Time = %.4fs ; Wall Time = %.4fs\n", total_time,
+        (te.tv_sec - ts.tv_sec) + (te.tv_usec - ts.tv_usec) / 1000000.0);
+
+    free(results);
+    free(games);
+
+    if (pdb != NULL)
+        snps_pdb_free(pdb);
 
     return 0;
 }
-
@@ -0,0 +1,78 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libsnps/snps.h>
+
+/* count the boards at every distance to the ordered board */
+int main(int argc, const char *argv[])
+{
+    /* usage: demo3 COLSxROWS DIRECTORY [DEEPEST] */
+    unsigned rows, cols, deepest = argc > 3 ? atoi(argv[3]) : 0;
+
+    if (argc < 3 || sscanf(argv[1], "%ux%u", &cols, &rows) != 2 ||
+        rows * cols < 2 || rows * cols > 16) {
+        fprintf(stderr, "Usage: %s COLSxROWS DIRECTORY [DEEPEST]\n",
+            argv[0]);
+        return 1;
+    }
+
+    unsigned char to[rows * cols];
+    for (int i = 0; i < rows * cols; ++i)
+        to[i] = (i + 1) % (rows * cols);
+
+    snps_game_t *game = snps_game_new(rows, cols, to, to);
+    snps_distances_t *distances = snps_enumerate(game, argv[2], 0, deepest);
+
+    if (distances == NULL) {
+        fprintf(stderr, "Unable to enumerate the boards in %s\n", argv[2]);
+        snps_game_free(game);
+        return 1;
+    }
+
+    unsigned long long total = 0;
+
+    for (int i = 0; i < distances->depths; ++i) {
+        printf("%3i: %llu\n", i, distances->counts[i]);
+        total += distances->counts[i];
+    }
+
+    printf("\nTotal: %llu\n", total);
+
+    for (int i = 0; i < distances->deepest_count; ++i) {
+        if (i == 0)
+            printf("\nDeepest:\n");
+        for (int j = 0; j < distances->size; ++j)
+            printf(j == 0 ? "%i" : " %i", distances->deepest[i][j]);
+        printf("\n");
+    }
+
+    snps_distances_free(distances);
+    snps_game_free(game);
+
+    return 0;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
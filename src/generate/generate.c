@@ -0,0 +1,287 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <libsnps/snps.h>
+
+/* the values games may be bucketed by */
+enum {
+    GENERATE_MANHATTAN,
+    GENERATE_LINEAR,
+    GENERATE_LENGTH,
+    GENERATE_VALUES,
+};
+
+/* how the games are generated */
+typedef struct {
+    unsigned rows;
+    unsigned columns;
+    unsigned count;
+    unsigned seed;
+    unsigned walk;
+    int permutation;
+    /* the value the games are bucketed by, -1 for none */
+    int key;
+    unsigned low;
+    unsigned high;
+    /* the budget of finding the optimal length, 0 skips it */
+    unsigned long long states;
+    const char *goal;
+} generate_settings_t;
+
+static const char *keys[] = {
+    "manhattan", "linear", "length",
+};
+
+/* prototypes */
+static void generate_values(snps_game_t *game,
+    const generate_settings_t *settings, int *values);
+static void generate_write(snps_game_t *game, unsigned index, unsigned walk,
+    const int *values);
+
+/* write solvable games of a shape as lines of the protocol of server,
+   annotated with the manhattan distance, the linear conflicts and if asked
+   for the optimal length, optionally count games for every value of one of
+   them within a range */
+int main(int argc, const char *argv[])
+{
+    generate_settings_t settings = {
+        .rows = 4,
+        .columns = 4,
+        .count = 10,
+        .seed = 42,
+        .walk = 0,
+        .permutation = 0,
+        .key = -1,
+        .low = 0,
+        .high = 0,
+        .states = 0,
+        .goal = NULL,
+    };
+
+    /* usage: generate [-g ROWSxCOLUMNS] [-n COUNT] [-s SEED] [-l WALK]
+       [-m walk|permutation] [-k manhattan|linear|length] [-b LOW-HIGH]
+       [-e STATES] [-t GOAL] */
+    for (int i = 1; i < argc; ++i) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (value == NULL || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            fprintf(stderr, "Usage: %s [-g ROWSxCOLUMNS] [-n COUNT] "
+                "[-s SEED] [-l WALK] [-m walk|permutation] "
+                "[-k manhattan|linear|length] [-b LOW-HIGH] [-e STATES] "
+                "[-t GOAL]\n", argv[0]);
+            return 1;
+        }
+
+        switch (argv[i++][1]) {
+            case 'g':
+                if (sscanf(value, "%ux%u", &settings.rows,
+                    &settings.columns) != 2)
+                    settings.rows = 0;
+                break;
+            case 'n': settings.count = atoi(value); break;
+            case 's': settings.seed = strtoul(value, NULL, 10); break;
+            case 'l': settings.walk = atoi(value); break;
+            case 'm':
+                settings.permutation = strcmp(value, "permutation") == 0;
+                break;
+            case 'k':
+                for (int j = 0; j < G_N_ELEMENTS(keys); ++j)
+                    if (strcmp(keys[j], value) == 0)
+                        settings.key = j;
+                break;
+            case 'b':
+                if (sscanf(value, "%u-%u", &settings.low,
+                    &settings.high) != 2)
+                    settings.high = settings.low = atoi(value);
+                break;
+            case 'e': settings.states = strtoull(value, NULL, 10); break;
+            case 't': settings.goal = value; break;
+            default:
+                fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+                return 1;
+        }
+    }
+
+    unsigned size = settings.rows * settings.columns;
+
+    if (size < 2 || size > SNPS_SIZE_MAX) {
+        fprintf(stderr, "Unusable shape %ux%u\n", settings.rows,
+            settings.columns);
+        return 1;
+    }
+
+    unsigned char goal[size];
+
+    if (settings.goal != NULL) {
+        snps_game_t *game = NULL;
+
+        /* a goal board reaching itself holds every tile exactly once */
+        if (snps_board_parse(settings.goal, size, goal) == 0)
+            game = snps_game_new(settings.rows, settings.columns, goal,
+                goal);
+
+        if (game == NULL || !snps_game_solvable(game)) {
+            fprintf(stderr, "Unusable goal board %s\n", settings.goal);
+            if (game != NULL)
+                snps_game_free(game);
+            return 1;
+        }
+
+        snps_game_free(game);
+    }
+
+    /* without a bucket every game counts, the optimal length needs a
+       budget of states so hard games are skipped instead of solved */
+    unsigned buckets = 1;
+    if (settings.key >= 0) {
+        if (settings.high < settings.low) {
+            fprintf(stderr, "Unusable range %u-%u\n", settings.low,
+                settings.high);
+            return 1;
+        }
+        buckets = settings.high - settings.low + 1;
+    }
+    if (settings.key == GENERATE_LENGTH && settings.states == 0)
+        settings.states = 10000000;
+
+    snps_generator_t *generator = snps_generator_new(settings.rows,
+        settings.columns, settings.goal != NULL ? goal : NULL,
+        settings.seed);
+    GRand *rand = g_rand_new_with_seed(settings.seed + 1);
+    unsigned *counts = g_new0(unsigned, buckets);
+    unsigned long long remaining = (unsigned long long) settings.count *
+        buckets, attempts = 1000 * remaining;
+    unsigned index = 0;
+
+    /* the arguments make the file reproducible */
+    printf("#");
+    for (int i = 0; i < argc; ++i)
+        printf(" %s", argv[i]);
+    printf("\n");
+
+    while (remaining > 0 && attempts-- > 0) {
+        unsigned walk = settings.walk != 0 ? settings.walk : 3 * size;
+
+        /* walks of random length reach every bucket, the optimal route is
+           never longer than the walk */
+        if (settings.walk == 0 && settings.key >= 0)
+            walk = g_rand_int_range(rand, MAX(settings.low, 1),
+                MAX(2 * settings.high, 3 * size) + 1);
+
+        snps_game_t *game = settings.permutation ?
+            snps_generator_permutation(generator) :
+            snps_generator_walk(generator, walk);
+        int values[GENERATE_VALUES];
+
+        generate_values(game, &settings, values);
+
+        if (settings.key >= 0) {
+            int value = values[settings.key];
+
+            if (value < (int) settings.low || value > (int) settings.high ||
+                counts[value - settings.low] == settings.count) {
+                snps_game_free(game);
+                continue;
+            }
+
+            ++counts[value - settings.low];
+        }
+
+        generate_write(game, ++index, settings.permutation ? 0 : walk,
+            values);
+        snps_game_free(game);
+        --remaining;
+    }
+
+    /* some values may be out of reach, like those of the wrong parity */
+    int status = 0;
+    for (int i = 0; i < buckets; ++i)
+        if (counts[i] < settings.count && settings.key >= 0) {
+            fprintf(stderr, "Only %u games with %s %u\n", counts[i],
+                keys[settings.key], settings.low + i);
+            status = 1;
+        }
+
+    g_free(counts);
+    g_rand_free(rand);
+    snps_generator_free(generator);
+
+    return status;
+}
+
+/* the manhattan distance, the manhattan distance plus the linear conflicts
+   and the optimal length of a game, -1 if it's unknown */
+static void generate_values(snps_game_t *game,
+    const generate_settings_t *settings, int *values)
+{
+    values[GENERATE_MANHATTAN] = snps_game_estimate(game);
+    snps_game_set_linear_conflict(game, 1);
+    values[GENERATE_LINEAR] = snps_game_estimate(game);
+    values[GENERATE_LENGTH] = -1;
+
+    if (settings->states == 0)
+        return;
+
+    snps_options_t options = {
+        .algorithm = SNPS_ALGORITHM_IDA,
+        .states = settings->states,
+    };
+    snps_result_t result;
+
+    if (snps_solve_with(game, &options, &result) == SNPS_STATUS_SOLVED)
+        values[GENERATE_LENGTH] = result.route->length - 1;
+
+    if (result.route != NULL)
+        snps_route_free(result.route);
+}
+
+/* write a game as a line of the protocol of server */
+static void generate_write(snps_game_t *game, unsigned index, unsigned walk,
+    const int *values)
+{
+    char from[4 * game->size], to[4 * game->size];
+
+    snps_board_format(game->from, game->size, from);
+    snps_board_format(game->to, game->size, to);
+
+    printf("id=%ux%u-%u size=%ux%u from=%s to=%s", game->rows,
+        game->columns, index, game->rows, game->columns, from, to);
+
+    if (walk != 0)
+        printf(" walk=%u", walk);
+    printf(" manhattan=%d linear=%d", values[GENERATE_MANHATTAN],
+        values[GENERATE_LINEAR]);
+    if (values[GENERATE_LENGTH] >= 0)
+        printf(" length=%d", values[GENERATE_LENGTH]);
+
+    printf("\n");
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
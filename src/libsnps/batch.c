@@ -0,0 +1,100 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "snps_private.h"
+
+#include <glib.h>
+
+/* data type, shared by all workers of a batch */
+typedef struct {
+    snps_game_t **games;
+    unsigned count;
+    snps_algorithm_t algorithm;
+    snps_result_t *results;
+    gint next;
+} snps_batch_t;
+
+/* prototypes */
+static gpointer snps_batch_worker(gpointer data);
+
+extern void snps_solve_batch(snps_game_t **games, unsigned count,
+    snps_algorithm_t algorithm, unsigned threads, snps_result_t *results)
+{
+    snps_batch_t batch = {
+        .games = games,
+        .count = count,
+        .algorithm = algorithm,
+        .results = results,
+        .next = 0,
+    };
+
+    if (count == 0)
+        return;
+
+    if (threads == 0)
+        threads = g_get_num_processors();
+    if (threads > count)
+        threads = count;
+
+    /* the calling thread works as well */
+    GThread **workers = g_new(GThread *, threads);
+    for (int i = 1; i < threads; ++i)
+        workers[i] = g_thread_new("snps-batch", snps_batch_worker, &batch);
+
+    snps_batch_worker(&batch);
+
+    for (int i = 1; i < threads; ++i)
+        g_thread_join(workers[i]);
+
+    g_free(workers);
+}
+
+/* solve games until none is left, every worker claims the next unsolved game
+   so a few hard games don't leave the others idle */
+static gpointer snps_batch_worker(gpointer data)
+{
+    snps_batch_t *batch = (snps_batch_t *) data;
+    snps_solver_t *solver = snps_solver_new();
+
+    while (42) {
+        int i = g_atomic_int_add(&batch->next, 1);
+
+        if (i >= batch->count)
+            break;
+
+        snps_options_t options = {
+            .algorithm = batch->algorithm,
+            .solver = solver,
+        };
+
+        snps_solve_with(batch->games[i], &options, &batch->results[i]);
+    }
+
+    snps_solver_free(solver);
+
+    return NULL;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,640 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#define SNPS_BFS_MANIFEST "manifest"
+#define SNPS_BFS_VERSION 1
+#define SNPS_BFS_MEMORY (64 << 20)
+#define SNPS_BFS_FAN_IN 64
+#define SNPS_BFS_BUFFER 65536
+
+/* data types, the files hold sorted boards without duplicates, each stored
+   as the varint encoded difference to the previous one */
+typedef struct {
+    FILE *file;
+    guchar *buffer;
+    gsize length;
+    gsize position;
+    guint64 value;
+} snps_reader_t;
+
+typedef struct {
+    FILE *file;
+    guchar *buffer;
+    gsize length;
+    guint64 value;
+    guint64 count;
+    gboolean failed;
+} snps_writer_t;
+
+typedef struct {
+    snps_game_t *game;
+    snps_packing_t packing;
+    const char *directory;
+    /* children of the current layer collected before they are sorted into
+       a run */
+    guint64 *keys;
+    gsize capacity;
+    gsize length;
+    unsigned runs;
+    GArray *counts;
+    gboolean failed;
+} snps_bfs_t;
+
+/* prototypes */
+static gboolean snps_bfs_resume(snps_bfs_t *bfs);
+static gboolean snps_bfs_parse(snps_bfs_t *bfs, const char *contents);
+static gboolean snps_bfs_save(snps_bfs_t *bfs);
+static gboolean snps_bfs_layer(snps_bfs_t *bfs, unsigned depth);
+static void snps_bfs_flush(snps_bfs_t *bfs, unsigned depth);
+static gboolean snps_bfs_merge(snps_bfs_t *bfs, unsigned depth,
+    unsigned first, unsigned count, const char *filename, gboolean exclude,
+    guint64 *written);
+static void snps_bfs_cleanup(snps_bfs_t *bfs);
+static char *snps_bfs_layer_path(snps_bfs_t *bfs, unsigned depth);
+static char *snps_bfs_run_path(snps_bfs_t *bfs, unsigned depth,
+    unsigned run);
+static int snps_key_compare(const void *a, const void *b);
+static snps_reader_t *snps_reader_open(const char *filename);
+static gboolean snps_reader_next(snps_reader_t *reader);
+static void snps_reader_close(snps_reader_t *reader);
+static snps_writer_t *snps_writer_open(const char *filename);
+static void snps_writer_put(snps_writer_t *writer, guint64 key);
+static gboolean snps_writer_close(snps_writer_t *writer);
+static void snps_heap_down(snps_reader_t **heap, unsigned count,
+    unsigned i);
+
+extern snps_distances_t *snps_enumerate(snps_game_t *game,
+    const char *directory, size_t memory, unsigned deepest)
+{
+    snps_bfs_t bfs = {
+        .game = game,
+        .directory = directory,
+        .counts = g_array_new(FALSE, FALSE, sizeof(guint64)),
+        .failed = FALSE,
+    };
+
+    /* only boards fitting into a single word are supported, larger ones
+       have far too many boards anyway */
+    snps_packing_init(&bfs.packing, game->size);
+    if (bfs.packing.words != 1 || g_mkdir_with_parents(directory, 0755) != 0
+        || snps_bfs_resume(&bfs) == FALSE) {
+        g_array_free(bfs.counts, TRUE);
+        return NULL;
+    }
+
+    bfs.capacity = MAX((memory != 0 ? memory : SNPS_BFS_MEMORY) /
+        sizeof(guint64), 1024);
+    bfs.keys = g_new(guint64, bfs.capacity);
+
+    /* an empty layer marks the end of the enumeration */
+    while (g_array_index(bfs.counts, guint64, bfs.counts->len - 1) != 0)
+        if (snps_bfs_layer(&bfs, bfs.counts->len) == FALSE ||
+            snps_bfs_save(&bfs) == FALSE) {
+            bfs.failed = TRUE;
+            break;
+        }
+
+    g_free(bfs.keys);
+    snps_bfs_cleanup(&bfs);
+
+    if (bfs.failed) {
+        g_array_free(bfs.counts, TRUE);
+        return NULL;
+    }
+
+    snps_distances_t *distances = g_slice_new(snps_distances_t);
+    distances->size = game->size;
+    distances->depths = bfs.counts->len - 1;
+    distances->counts = g_new(unsigned long long, distances->depths);
+    for (int i = 0; i < distances->depths; ++i)
+        distances->counts[i] = g_array_index(bfs.counts, guint64, i);
+
+    distances->deepest = g_new(unsigned char *, MAX(deepest, 1));
+    distances->deepest_count = 0;
+
+    char *filename = snps_bfs_layer_path(&bfs, distances->depths - 1);
+    snps_reader_t *reader = deepest > 0 ? snps_reader_open(filename) : NULL;
+    g_free(filename);
+
+    while (reader != NULL && distances->deepest_count < deepest &&
+        snps_reader_next(reader)) {
+        unsigned char *board = g_slice_alloc(game->size);
+        snps_key_unpack(&bfs.packing, &reader->value, board);
+        distances->deepest[distances->deepest_count++] = board;
+    }
+
+    if (reader != NULL)
+        snps_reader_close(reader);
+
+    g_array_free(bfs.counts, TRUE);
+
+    return distances;
+}
+
+extern void snps_distances_free(snps_distances_t *distances)
+{
+    for (int i = 0; i < distances->deepest_count; ++i)
+        g_slice_free1(distances->size, distances->deepest[i]);
+    g_free(distances->deepest);
+    g_free(distances->counts);
+    g_slice_free(snps_distances_t, distances);
+}
+
+/* read the counts of the completed layers from the manifest, a new
+   enumeration starts with the goal board as its only layer */
+static gboolean snps_bfs_resume(snps_bfs_t *bfs)
+{
+    snps_game_t *game = bfs->game;
+    char *filename = g_build_filename(bfs->directory, SNPS_BFS_MANIFEST,
+        NULL);
+    char *contents = NULL;
+
+    snps_bfs_cleanup(bfs);
+
+    if (g_file_get_contents(filename, &contents, NULL, NULL) == FALSE) {
+        guint64 goal;
+        snps_key_pack(&bfs->packing, &goal, game->to);
+
+        char *layer = snps_bfs_layer_path(bfs, 0);
+        snps_writer_t *writer = snps_writer_open(layer);
+        g_free(layer);
+        g_free(filename);
+
+        if (writer == NULL)
+            return FALSE;
+
+        snps_writer_put(writer, goal);
+        g_array_append_val(bfs->counts, writer->count);
+
+        return snps_writer_close(writer) && snps_bfs_save(bfs);
+    }
+
+    gboolean result = snps_bfs_parse(bfs, contents);
+    g_free(contents);
+    g_free(filename);
+
+    return result;
+}
+
+/* restore the counts from the contents of a manifest, which has to belong
+   to the same goal board */
+static gboolean snps_bfs_parse(snps_bfs_t *bfs, const char *contents)
+{
+    snps_game_t *game = bfs->game;
+    char **lines = g_strsplit(contents, "\n", -1);
+    unsigned version, rows, columns, layers;
+    gboolean result = lines[0] != NULL && sscanf(lines[0],
+        "snps-bfs %u %u %u %u", &version, &rows, &columns, &layers) == 4 &&
+        version == SNPS_BFS_VERSION && rows == game->rows &&
+        columns == game->columns && layers > 0 &&
+        g_strv_length(lines) >= layers + 2;
+
+    if (result) {
+        char **tiles = g_strsplit(lines[1], " ", -1);
+        result = g_strv_length(tiles) == game->size;
+        for (int i = 0; result && i < game->size; ++i)
+            result = strtoul(tiles[i], NULL, 10) == game->to[i];
+        g_strfreev(tiles);
+    }
+
+    for (int i = 0; result && i < layers; ++i) {
+        guint64 count = g_ascii_strtoull(lines[i + 2], NULL, 10);
+        g_array_append_val(bfs->counts, count);
+    }
+
+    g_strfreev(lines);
+
+    return result;
+}
+
+/* replace the manifest after a layer is complete */
+static gboolean snps_bfs_save(snps_bfs_t *bfs)
+{
+    snps_game_t *game = bfs->game;
+    GString *contents = g_string_new(NULL);
+
+    g_string_append_printf(contents, "snps-bfs %u %u %u %u\n",
+        SNPS_BFS_VERSION, game->rows, game->columns, bfs->counts->len);
+    for (int i = 0; i < game->size; ++i)
+        g_string_append_printf(contents, i == 0 ? "%u" : " %u", game->to[i]);
+    g_string_append_c(contents, '\n');
+    for (int i = 0; i < bfs->counts->len; ++i)
+        g_string_append_printf(contents, "%" G_GUINT64_FORMAT "\n",
+            g_array_index(bfs->counts, guint64, i));
+
+    char *filename = g_build_filename(bfs->directory, SNPS_BFS_MANIFEST,
+        NULL);
+    gboolean result = g_file_set_contents(filename, contents->str,
+        contents->len, NULL);
+
+    g_free(filename);
+    g_string_free(contents, TRUE);
+
+    return result;
+}
+
+/* expand every board of the previous layer into sorted runs and merge them
+   into the next layer, dropping the boards of the two previous layers */
+static gboolean snps_bfs_layer(snps_bfs_t *bfs, unsigned depth)
+{
+    snps_game_t *game = bfs->game;
+    char *filename = snps_bfs_layer_path(bfs, depth - 1);
+    snps_reader_t *reader = snps_reader_open(filename);
+    g_free(filename);
+
+    if (reader == NULL)
+        return FALSE;
+
+    bfs->length = 0;
+    bfs->runs = 0;
+
+    while (snps_reader_next(reader)) {
+        guint64 key = reader->value;
+        int p = 0;
+
+        while (snps_key_get(&bfs->packing, &key, p) != 0)
+            ++p;
+
+        int cells[4];
+        snps_neighbours(game, p, cells);
+
+        for (int i = 0; i < 4; ++i) {
+            if (cells[i] < 0)
+                continue;
+
+            if (bfs->length == bfs->capacity)
+                snps_bfs_flush(bfs, depth);
+
+            guint64 child = key;
+            snps_key_move(&bfs->packing, &child, p, cells[i]);
+            bfs->keys[bfs->length++] = child;
+        }
+    }
+
+    snps_reader_close(reader);
+    snps_bfs_flush(bfs, depth);
+
+    /* merge as many runs at once as files may be open, the runs of a
+       merge are numbered after all existing ones */
+    unsigned first = 0;
+    while (bfs->failed == FALSE && bfs->runs - first > SNPS_BFS_FAN_IN) {
+        char *run = snps_bfs_run_path(bfs, depth, bfs->runs);
+        guint64 written;
+
+        if (snps_bfs_merge(bfs, depth, first, SNPS_BFS_FAN_IN, run, FALSE,
+            &written) == FALSE)
+            bfs->failed = TRUE;
+
+        g_free(run);
+        first += SNPS_BFS_FAN_IN;
+        ++bfs->runs;
+    }
+
+    /* the layer appears under its name once it's complete */
+    char *layer = snps_bfs_layer_path(bfs, depth);
+    char *partial = g_strconcat(layer, ".partial", NULL);
+    guint64 count = 0;
+
+    if (bfs->failed == FALSE && snps_bfs_merge(bfs, depth, first,
+        bfs->runs - first, partial, TRUE, &count) &&
+        g_rename(partial, layer) == 0)
+        g_array_append_val(bfs->counts, count);
+    else
+        bfs->failed = TRUE;
+
+    g_free(partial);
+    g_free(layer);
+
+    return bfs->failed == FALSE;
+}
+
+/* sort the collected children and write them as a run */
+static void snps_bfs_flush(snps_bfs_t *bfs, unsigned depth)
+{
+    if (bfs->length == 0)
+        return;
+
+    qsort(bfs->keys, bfs->length, sizeof(guint64), snps_key_compare);
+
+    char *filename = snps_bfs_run_path(bfs, depth, bfs->runs++);
+    snps_writer_t *writer = snps_writer_open(filename);
+    g_free(filename);
+
+    if (writer == NULL) {
+        bfs->failed = TRUE;
+        bfs->length = 0;
+        return;
+    }
+
+    for (gsize i = 0; i < bfs->length; ++i)
+        if (i == 0 || bfs->keys[i] != bfs->keys[i - 1])
+            snps_writer_put(writer, bfs->keys[i]);
+
+    if (snps_writer_close(writer) == FALSE)
+        bfs->failed = TRUE;
+
+    bfs->length = 0;
+}
+
+/* merge a number of runs into a file without duplicates and remove them,
+   with exclude boards of the two previous layers are dropped as well */
+static gboolean snps_bfs_merge(snps_bfs_t *bfs, unsigned depth,
+    unsigned first, unsigned count, const char *filename, gboolean exclude,
+    guint64 *written)
+{
+    snps_reader_t *heap[count];
+    snps_reader_t *previous[2] = {NULL, NULL};
+    snps_writer_t *writer = snps_writer_open(filename);
+    unsigned length = 0;
+    gboolean result = writer != NULL;
+
+    for (unsigned i = 0; i < count; ++i) {
+        char *run = snps_bfs_run_path(bfs, depth, first + i);
+        snps_reader_t *reader = snps_reader_open(run);
+        g_free(run);
+
+        if (reader == NULL)
+            result = FALSE;
+        else if (snps_reader_next(reader))
+            heap[length++] = reader;
+        else
+            snps_reader_close(reader);
+    }
+
+    for (int i = 0; exclude && i < 2 && i < depth; ++i) {
+        char *layer = snps_bfs_layer_path(bfs, depth - 1 - i);
+        previous[i] = snps_reader_open(layer);
+        g_free(layer);
+
+        if (previous[i] == NULL)
+            result = FALSE;
+        else if (snps_reader_next(previous[i]) == FALSE) {
+            snps_reader_close(previous[i]);
+            previous[i] = NULL;
+        }
+    }
+
+    for (int i = length / 2 - 1; i >= 0; --i)
+        snps_heap_down(heap, length, i);
+
+    guint64 last = 0;
+    gboolean started = FALSE;
+
+    while (result && length > 0) {
+        guint64 key = heap[0]->value;
+
+        if (snps_reader_next(heap[0]) == FALSE) {
+            snps_reader_close(heap[0]);
+            heap[0] = heap[--length];
+        }
+        snps_heap_down(heap, length, 0);
+
+        if (started && key == last)
+            continue;
+        started = TRUE;
+        last = key;
+
+        gboolean known = FALSE;
+        for (int i = 0; i < 2; ++i) {
+            while (previous[i] != NULL && previous[i]->value < key)
+                if (snps_reader_next(previous[i]) == FALSE) {
+                    snps_reader_close(previous[i]);
+                    previous[i] = NULL;
+                }
+            if (previous[i] != NULL && previous[i]->value == key)
+                known = TRUE;
+        }
+
+        if (known == FALSE)
+            snps_writer_put(writer, key);
+    }
+
+    for (unsigned i = 0; i < length; ++i)
+        snps_reader_close(heap[i]);
+    for (int i = 0; i < 2; ++i)
+        if (previous[i] != NULL)
+            snps_reader_close(previous[i]);
+
+    if (writer != NULL) {
+        *written = writer->count;
+        result &= snps_writer_close(writer);
+    }
+
+    for (unsigned i = 0; i < count; ++i) {
+        char *run = snps_bfs_run_path(bfs, depth, first + i);
+        g_remove(run);
+        g_free(run);
+    }
+
+    return result;
+}
+
+/* remove runs and partial layers left behind by an interruption */
+static void snps_bfs_cleanup(snps_bfs_t *bfs)
+{
+    GDir *dir = g_dir_open(bfs->directory, 0, NULL);
+    const char *name;
+
+    if (dir == NULL)
+        return;
+
+    while ((name = g_dir_read_name(dir)) != NULL)
+        if (g_str_has_prefix(name, "run-") ||
+            g_str_has_suffix(name, ".partial")) {
+            char *filename = g_build_filename(bfs->directory, name, NULL);
+            g_remove(filename);
+            g_free(filename);
+        }
+
+    g_dir_close(dir);
+}
+
+/* the file of the boards at a distance */
+static char *snps_bfs_layer_path(snps_bfs_t *bfs, unsigned depth)
+{
+    char name[32];
+    g_snprintf(name, sizeof(name), "layer-%04u", depth);
+
+    return g_build_filename(bfs->directory, name, NULL);
+}
+
+/* the file of a sorted run of the children of a layer */
+static char *snps_bfs_run_path(snps_bfs_t *bfs, unsigned depth,
+    unsigned run)
+{
+    char name[32];
+    g_snprintf(name, sizeof(name), "run-%04u-%06u", depth, run);
+
+    return g_build_filename(bfs->directory, name, NULL);
+}
+
+/* order keys for qsort */
+static int snps_key_compare(const void *a, const void *b)
+{
+    guint64 x = *(const guint64 *) a, y = *(const guint64 *) b;
+
+    return (x > y) - (x < y);
+}
+
+/* open a file of boards for reading */
+static snps_reader_t *snps_reader_open(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL)
+        return NULL;
+
+    snps_reader_t *reader = g_slice_new(snps_reader_t);
+    reader->file = file;
+    reader->buffer = g_malloc(SNPS_BFS_BUFFER);
+    reader->length = 0;
+    reader->position = 0;
+    reader->value = 0;
+
+    return reader;
+}
+
+/* decode the next board into value, FALSE at the end of the file */
+static gboolean snps_reader_next(snps_reader_t *reader)
+{
+    guint64 delta = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (reader->position == reader->length) {
+            reader->length = fread(reader->buffer, 1, SNPS_BFS_BUFFER,
+                reader->file);
+            reader->position = 0;
+
+            if (reader->length == 0)
+                return FALSE;
+        }
+
+        guchar byte = reader->buffer[reader->position++];
+        delta |= (guint64) (byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0) {
+            reader->value += delta;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* close a file of boards */
+static void snps_reader_close(snps_reader_t *reader)
+{
+    fclose(reader->file);
+    g_free(reader->buffer);
+    g_slice_free(snps_reader_t, reader);
+}
+
+/* create a file of boards, which have to be added in ascending order */
+static snps_writer_t *snps_writer_open(const char *filename)
+{
+    FILE *file = fopen(filename, "wb");
+
+    if (file == NULL)
+        return NULL;
+
+    snps_writer_t *writer = g_slice_new(snps_writer_t);
+    writer->file = file;
+    writer->buffer = g_malloc(SNPS_BFS_BUFFER);
+    writer->length = 0;
+    writer->value = 0;
+    writer->count = 0;
+    writer->failed = FALSE;
+
+    return writer;
+}
+
+/* append a board, encoded as the difference to the previous one */
+static void snps_writer_put(snps_writer_t *writer, guint64 key)
+{
+    guint64 delta = key - writer->value;
+
+    /* a varint takes up to ten bytes */
+    if (writer->length + 10 > SNPS_BFS_BUFFER) {
+        writer->failed |= fwrite(writer->buffer, 1, writer->length,
+            writer->file) != writer->length;
+        writer->length = 0;
+    }
+
+    while (delta >= 0x80) {
+        writer->buffer[writer->length++] = (delta & 0x7f) | 0x80;
+        delta >>= 7;
+    }
+    writer->buffer[writer->length++] = delta;
+
+    writer->value = key;
+    ++writer->count;
+}
+
+/* write the rest of the boards and close the file, FALSE on errors */
+static gboolean snps_writer_close(snps_writer_t *writer)
+{
+    gboolean failed = writer->failed;
+
+    failed |= fwrite(writer->buffer, 1, writer->length, writer->file) !=
+        writer->length;
+    failed |= fclose(writer->file) != 0;
+
+    g_free(writer->buffer);
+    g_slice_free(snps_writer_t, writer);
+
+    return failed == FALSE;
+}
+
+/* restore the order of a heap of readers by their current board below the
+   reader at i */
+static void snps_heap_down(snps_reader_t **heap, unsigned count, unsigned i)
+{
+    while (42) {
+        unsigned smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+
+        if (left < count && heap[left]->value < heap[smallest]->value)
+            smallest = left;
+        if (right < count && heap[right]->value < heap[smallest]->value)
+            smallest = right;
+
+        if (smallest == i)
+            break;
+
+        snps_reader_t *reader = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = reader;
+        i = smallest;
+    }
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,491 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+/* the moves of the blank in the order of snps_neighbours */
+#define SNPS_DECOMPOSE_DIRECTIONS "LRUD"
+/* the cells of the search placing the last two tiles of a line in a tight
+   spot and the number of states of the tiles and the blank within them */
+#define SNPS_DECOMPOSE_WINDOW 6
+#define SNPS_DECOMPOSE_WINDOW_STATES \
+    (SNPS_DECOMPOSE_WINDOW * SNPS_DECOMPOSE_WINDOW * SNPS_DECOMPOSE_WINDOW)
+
+/* data type, the board is solved line by line from the outside, the cells
+   of solved lines and of tiles kept in place for a while are locked and
+   never entered by the searches moving a tile or the blank, which look at
+   pairs of the cell of the tile and the cell of the blank */
+typedef struct {
+    snps_game_t *game;
+    snps_budget_t *budget;
+    snps_stats_t stats;
+    unsigned char *board;
+    unsigned blank;
+    unsigned char *locked;
+    GString *moves;
+    /* the states of a search indexed by tile cell * size + blank cell, a
+       state was reached by the current search if its generation matches */
+    guint32 *generations;
+    guint32 *parents;
+    guint32 *costs;
+    guint32 *cells;
+    guint32 generation;
+    snps_queue_t *open;
+} snps_decompose_t;
+
+/* prototypes */
+static void snps_decompose_init(snps_decompose_t *decompose,
+    snps_game_t *game, snps_budget_t *budget);
+static void snps_decompose_clear(snps_decompose_t *decompose);
+static int snps_decompose_line(snps_decompose_t *decompose,
+    const unsigned *cells, unsigned count, int inward);
+static int snps_decompose_tile(snps_decompose_t *decompose, unsigned cell);
+static int snps_decompose_move(snps_decompose_t *decompose, unsigned tile,
+    unsigned target);
+static unsigned snps_decompose_estimate(snps_decompose_t *decompose,
+    unsigned tile, guint32 state, unsigned target);
+static int snps_decompose_window(snps_decompose_t *decompose,
+    const unsigned *cells);
+static int snps_decompose_rest(snps_decompose_t *decompose, unsigned top,
+    unsigned bottom, unsigned left, unsigned right);
+static void snps_decompose_slide(snps_decompose_t *decompose,
+    unsigned cell);
+
+extern snps_route_t *snps_run_decompose(snps_game_t *game,
+    snps_budget_t *budget, snps_stats_t *stats)
+{
+    snps_decompose_t decompose;
+    snps_decompose_init(&decompose, game, budget);
+
+    unsigned columns = game->columns, goal = 0;
+    unsigned top = 0, bottom = game->rows, left = 0, right = columns;
+    unsigned cells[MAX(game->rows, game->columns)];
+    int solved = 1;
+
+    while (game->to[goal] != 0)
+        ++goal;
+
+    /* peel off the longer side until at most 3x3 cells are left, always on
+       the side away from the goal cell of the blank, boards one cell wide
+       have no other way than the exact search */
+    while (solved && (bottom - top > 3 || right - left > 3) &&
+        bottom - top > 1 && right - left > 1) {
+        unsigned count = 0;
+
+        if (bottom - top >= right - left) {
+            unsigned row = goal / columns == top ? --bottom : top++;
+            for (unsigned column = left; column < right; ++column)
+                cells[count++] = row * columns + column;
+            solved = snps_decompose_line(&decompose, cells, count,
+                row < top ? (int) columns : -(int) columns);
+        } else {
+            unsigned column = goal % columns == left ? --right : left++;
+            for (unsigned row = top; row < bottom; ++row)
+                cells[count++] = row * columns + column;
+            solved = snps_decompose_line(&decompose, cells, count,
+                column < left ? 1 : -1);
+        }
+    }
+
+    snps_route_t *route = NULL;
+    if (solved && snps_decompose_rest(&decompose, top, bottom, left, right))
+        route = snps_route_new_moves(game, decompose.moves->str,
+            decompose.moves->len);
+
+    decompose.stats.depth = decompose.moves->len;
+    if (stats != NULL)
+        *stats = decompose.stats;
+
+    snps_decompose_clear(&decompose);
+
+    return route;
+}
+
+static void snps_decompose_init(snps_decompose_t *decompose,
+    snps_game_t *game, snps_budget_t *budget)
+{
+    gsize states = (gsize) game->size * game->size;
+
+    decompose->game = game;
+    decompose->budget = budget;
+    decompose->stats = (snps_stats_t) {0, 0, 0, 0.0};
+    decompose->board = g_slice_copy(game->size, game->from);
+    decompose->blank = 0;
+    while (decompose->board[decompose->blank] != 0)
+        ++decompose->blank;
+    decompose->locked = g_slice_alloc0(game->size);
+    decompose->moves = g_string_new(NULL);
+    decompose->generations = g_new0(guint32, states);
+    decompose->parents = g_new(guint32, states);
+    decompose->costs = g_new(guint32, states);
+    decompose->cells = g_new(guint32, states);
+    decompose->generation = 0;
+    decompose->open = snps_queue_new();
+}
+
+static void snps_decompose_clear(snps_decompose_t *decompose)
+{
+    g_slice_free1(decompose->game->size, decompose->board);
+    g_slice_free1(decompose->game->size, decompose->locked);
+    g_string_free(decompose->moves, TRUE);
+    g_free(decompose->generations);
+    g_free(decompose->parents);
+    g_free(decompose->costs);
+    g_free(decompose->cells);
+    snps_queue_free(decompose->open);
+}
+
+/* put the goal tiles into the cells of a line, inward leads from a cell of
+   the line to the next one towards the remaining board, the tiles are
+   placed one by one except for the last two, the last tile is parked on
+   the cell of the second to last one and the second to last tile next to
+   it, so both slide into place by rotating them with the blank */
+static int snps_decompose_line(snps_decompose_t *decompose,
+    const unsigned *cells, unsigned count, int inward)
+{
+    const unsigned char *to = decompose->game->to;
+    unsigned char *board = decompose->board;
+    unsigned first = cells[count - 2], last = cells[count - 1];
+    unsigned next = first + inward;
+
+    for (unsigned i = 0; i + 2 < count; ++i) {
+        if (!snps_decompose_tile(decompose, cells[i]))
+            return 0;
+        decompose->locked[cells[i]] = 1;
+    }
+
+    if (board[first] == to[first] && board[last] == to[last]) {
+        decompose->locked[first] = decompose->locked[last] = 1;
+        return 1;
+    }
+
+    if (!snps_decompose_move(decompose, to[last], first))
+        return 0;
+    decompose->locked[first] = 1;
+
+    /* the second to last tile can't leave the last cell, or the cell next
+       to it while the blank is in the last cell, without trapping the
+       blank there, instead both tiles are sorted out by a search within
+       the last two cells of the line and of the two lines next to it */
+    if (!snps_decompose_move(decompose, to[first], next)) {
+        unsigned window[] = {
+            first, last, next, last + inward, next + inward,
+            last + 2 * inward,
+        };
+
+        decompose->locked[last] = 1;
+        if (board[last] == to[first] &&
+            !snps_decompose_move(decompose, 0, last + inward))
+            return 0;
+        decompose->locked[first] = decompose->locked[last] = 0;
+
+        if (!snps_decompose_window(decompose, window))
+            return 0;
+        decompose->locked[first] = decompose->locked[last] = 1;
+
+        return 1;
+    }
+    decompose->locked[next] = 1;
+
+    if (!snps_decompose_move(decompose, 0, last))
+        return 0;
+    decompose->locked[next] = 0;
+
+    snps_decompose_slide(decompose, first);
+    snps_decompose_slide(decompose, next);
+    decompose->locked[last] = 1;
+
+    return 1;
+}
+
+/* move the goal tile of a cell into it */
+static int snps_decompose_tile(snps_decompose_t *decompose, unsigned cell)
+{
+    return snps_decompose_move(decompose, decompose->game->to[cell], cell);
+}
+
+/* move a tile, or the blank for tile 0, to the target cell avoiding the
+   locked cells, an A* search over the cells of the tile and the blank
+   which reopens no state, returns 0 if the budget ran out or the target
+   can't be reached */
+static int snps_decompose_move(snps_decompose_t *decompose, unsigned tile,
+    unsigned target)
+{
+    snps_game_t *game = decompose->game;
+    unsigned size = game->size, start = decompose->blank;
+
+    if (tile != 0) {
+        start = 0;
+        while (decompose->board[start] != tile)
+            ++start;
+        start = start * size + decompose->blank;
+    }
+
+    if (tile != 0 ? start / size == target : start == target)
+        return 1;
+
+    guint32 generation = ++decompose->generation, state, end = SNPS_NONE;
+    unsigned h = snps_decompose_estimate(decompose, tile, start, target);
+
+    snps_queue_reset(decompose->open);
+    decompose->generations[start] = generation;
+    decompose->costs[start] = 0;
+    snps_queue_push(decompose->open, h, h, start);
+
+    while (end == SNPS_NONE &&
+        (state = snps_queue_pop(decompose->open)) != SNPS_NONE) {
+        unsigned cell = state / size, blank = state % size;
+        int neighbours[4];
+
+        if (snps_budget_stop(decompose->budget, ++decompose->stats.expanded))
+            return 0;
+
+        snps_neighbours(game, blank, neighbours);
+        for (int i = 0; i < 4; ++i) {
+            int q = neighbours[i];
+
+            if (q < 0 || decompose->locked[q])
+                continue;
+
+            /* the tile slides into the blank if the blank moves onto it */
+            guint32 child = (tile != 0 && q == cell ? blank : cell) * size +
+                q;
+            ++decompose->stats.compared;
+
+            if (decompose->generations[child] == generation)
+                continue;
+
+            decompose->generations[child] = generation;
+            decompose->parents[child] = state;
+            decompose->costs[child] = decompose->costs[state] + 1;
+
+            if (tile != 0 ? child / size == target : (unsigned) q == target) {
+                end = child;
+                break;
+            }
+
+            h = snps_decompose_estimate(decompose, tile, child, target);
+            snps_queue_push(decompose->open, decompose->costs[child] + h, h,
+                child);
+        }
+    }
+
+    if (end == SNPS_NONE)
+        return 0;
+
+    /* the cells of the blank along the route, backwards */
+    unsigned count = 0;
+    for (state = end; state != start; state = decompose->parents[state])
+        decompose->cells[count++] = state % size;
+
+    while (count > 0)
+        snps_decompose_slide(decompose, decompose->cells[--count]);
+
+    return 1;
+}
+
+/* estimated moves from a state of a search to the target cell, without a
+   tile those of the blank, otherwise the blank has to get next to the tile
+   and circle it on every further step */
+static unsigned snps_decompose_estimate(snps_decompose_t *decompose,
+    unsigned tile, guint32 state, unsigned target)
+{
+    snps_game_t *game = decompose->game;
+    unsigned cell = state / game->size, blank = state % game->size;
+    unsigned distance = ABS(game->cell_rows[cell] - game->cell_rows[target])
+        + ABS(game->cell_columns[cell] - game->cell_columns[target]);
+
+    if (tile == 0)
+        return ABS(game->cell_rows[blank] - game->cell_rows[target]) +
+            ABS(game->cell_columns[blank] - game->cell_columns[target]);
+
+    return distance == 0 ? 0 : 5 * (distance - 1) +
+        ABS(game->cell_rows[blank] - game->cell_rows[cell]) +
+        ABS(game->cell_columns[blank] - game->cell_columns[cell]);
+}
+
+/* move the goal tiles of the first two of six cells into them while
+   moving the blank within the cells only, a breadth first search over the
+   cells of both tiles and the blank, the other tiles are interchangeable
+   so both tiles can be put anywhere */
+static int snps_decompose_window(snps_decompose_t *decompose,
+    const unsigned *cells)
+{
+    snps_game_t *game = decompose->game;
+    unsigned char parents[SNPS_DECOMPOSE_WINDOW_STATES];
+    unsigned char queue[SNPS_DECOMPOSE_WINDOW_STATES];
+    unsigned char seen[SNPS_DECOMPOSE_WINDOW_STATES] = {0};
+    unsigned start = 0, found = 0, head = 0, tail = 0, end = SNPS_NONE;
+
+    for (int i = 0; i < SNPS_DECOMPOSE_WINDOW; ++i) {
+        unsigned char tile = decompose->board[cells[i]];
+
+        if (tile == game->to[cells[0]])
+            start += i * SNPS_DECOMPOSE_WINDOW * SNPS_DECOMPOSE_WINDOW;
+        else if (tile == game->to[cells[1]])
+            start += i * SNPS_DECOMPOSE_WINDOW;
+        else if (tile == 0)
+            start += i;
+        else
+            continue;
+        ++found;
+    }
+
+    /* a search stopped by its budget may leave them elsewhere */
+    if (found < 3)
+        return 0;
+
+    seen[start] = 1;
+    queue[tail++] = start;
+
+    while (head < tail && end == SNPS_NONE) {
+        unsigned state = queue[head++];
+        unsigned first = state / SNPS_DECOMPOSE_WINDOW / SNPS_DECOMPOSE_WINDOW;
+        unsigned second = state / SNPS_DECOMPOSE_WINDOW %
+            SNPS_DECOMPOSE_WINDOW;
+        unsigned blank = state % SNPS_DECOMPOSE_WINDOW;
+        int neighbours[4];
+
+        if (snps_budget_stop(decompose->budget, ++decompose->stats.expanded))
+            return 0;
+
+        snps_neighbours(game, cells[blank], neighbours);
+        for (int i = 0; i < 4; ++i) {
+            unsigned q = 0;
+
+            while (q < SNPS_DECOMPOSE_WINDOW &&
+                (int) cells[q] != neighbours[i])
+                ++q;
+            if (q == SNPS_DECOMPOSE_WINDOW)
+                continue;
+
+            unsigned child = ((first == q ? blank : first) *
+                SNPS_DECOMPOSE_WINDOW + (second == q ? blank : second)) *
+                SNPS_DECOMPOSE_WINDOW + q;
+            ++decompose->stats.compared;
+
+            if (seen[child])
+                continue;
+
+            seen[child] = 1;
+            parents[child] = state;
+            queue[tail++] = child;
+
+            if (child / SNPS_DECOMPOSE_WINDOW == 1) {
+                end = child;
+                break;
+            }
+        }
+    }
+
+    if (end == SNPS_NONE)
+        return 0;
+
+    unsigned count = 0;
+    for (unsigned state = end; state != start; state = parents[state])
+        queue[count++] = state % SNPS_DECOMPOSE_WINDOW;
+
+    while (count > 0)
+        snps_decompose_slide(decompose, cells[queue[--count]]);
+
+    return 1;
+}
+
+/* solve the remaining cells exactly as a game of their own, the tiles are
+   renumbered by their goal cells within the remaining board */
+static int snps_decompose_rest(snps_decompose_t *decompose, unsigned top,
+    unsigned bottom, unsigned left, unsigned right)
+{
+    snps_game_t *game = decompose->game;
+    unsigned rows = bottom - top, columns = right - left, count = 0;
+    unsigned char from[rows * columns], to[rows * columns], labels[256];
+
+    for (unsigned row = top; row < bottom; ++row)
+        for (unsigned column = left; column < right; ++column) {
+            unsigned char tile = game->to[row * game->columns + column];
+            labels[tile] = tile == 0 ? 0 : ++count;
+            to[(row - top) * columns + column - left] = labels[tile];
+        }
+
+    for (unsigned row = top; row < bottom; ++row)
+        for (unsigned column = left; column < right; ++column)
+            from[(row - top) * columns + column - left] =
+                labels[decompose->board[row * game->columns + column]];
+
+    snps_game_t *rest = snps_game_new(rows, columns, from, to);
+    snps_game_set_linear_conflict(rest, 1);
+
+    snps_stats_t stats;
+    snps_route_t *route = snps_run_ida(rest, NULL, decompose->budget, &stats);
+
+    int solved = route != NULL;
+
+    decompose->stats.compared += stats.compared;
+    decompose->stats.expanded += stats.expanded;
+
+    if (solved) {
+        for (unsigned i = 0; i + 1 < route->length; ++i) {
+            const char *move = strchr(SNPS_DECOMPOSE_DIRECTIONS,
+                snps_route_move(route, i));
+            int neighbours[4];
+
+            snps_neighbours(game, decompose->blank, neighbours);
+            snps_decompose_slide(decompose,
+                neighbours[move - SNPS_DECOMPOSE_DIRECTIONS]);
+        }
+        snps_route_free(route);
+    }
+
+    snps_game_free(rest);
+
+    return solved;
+}
+
+/* slide the tile at a cell next to the blank into it, a move undoing the
+   previous one cancels it out */
+static void snps_decompose_slide(snps_decompose_t *decompose,
+    unsigned cell)
+{
+    GString *moves = decompose->moves;
+    char move = snps_route_direction(decompose->game, decompose->blank,
+        cell);
+    const char *inverse = "RLDU";
+    unsigned index = strchr(SNPS_DECOMPOSE_DIRECTIONS, move) -
+        SNPS_DECOMPOSE_DIRECTIONS;
+
+    if (moves->len > 0 && moves->str[moves->len - 1] == inverse[index])
+        g_string_truncate(moves, moves->len - 1);
+    else
+        g_string_append_c(moves, move);
+
+    decompose->board[decompose->blank] = decompose->board[cell];
+    decompose->board[cell] = 0;
+    decompose->blank = cell;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
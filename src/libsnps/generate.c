@@ -0,0 +1,210 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+/* data type */
+struct snps_generator {
+    unsigned rows;
+    unsigned columns;
+    unsigned size;
+    unsigned char *goal;
+    GRand *rand;
+};
+
+extern snps_generator_t *snps_generator_new(unsigned rows, unsigned columns,
+    const unsigned char *goal, unsigned seed)
+{
+    if (rows == 0 || columns == 0 || rows * columns > SNPS_SIZE_MAX)
+        return NULL;
+
+    /* only a goal board holding every tile exactly once is solvable */
+    if (goal != NULL) {
+        snps_game_t *game = snps_game_new(rows, columns, goal, goal);
+        int solvable = snps_game_solvable(game);
+
+        snps_game_free(game);
+        if (!solvable)
+            return NULL;
+    }
+
+    snps_generator_t *generator = g_slice_new(snps_generator_t);
+    generator->rows = rows;
+    generator->columns = columns;
+    generator->size = rows * columns;
+    generator->goal = g_slice_alloc(generator->size);
+    generator->rand = g_rand_new_with_seed(seed);
+
+    for (int i = 0; i < generator->size; ++i)
+        generator->goal[i] = goal != NULL ? goal[i] :
+            (i + 1) % generator->size;
+
+    return generator;
+}
+
+extern void snps_generator_free(snps_generator_t *generator)
+{
+    g_rand_free(generator->rand);
+    g_slice_free1(generator->size, generator->goal);
+    g_slice_free(snps_generator_t, generator);
+}
+
+extern snps_game_t *snps_generator_walk(snps_generator_t *generator,
+    unsigned moves)
+{
+    unsigned rows = generator->rows, columns = generator->columns;
+    unsigned char from[generator->size];
+    int blank = 0, previous = -1;
+
+    memcpy(from, generator->goal, generator->size);
+    while (blank < generator->size - 1 && from[blank] != 0)
+        ++blank;
+
+    for (int j = 0; j < moves; ++j) {
+        int cells[4], count = 0;
+        int row = TRANSLATE_1D_TO_ROW(blank, columns);
+        int column = TRANSLATE_1D_TO_COLUMN(blank, columns);
+
+        if (row > 0)
+            cells[count++] = blank - columns;
+        if (row < rows - 1)
+            cells[count++] = blank + columns;
+        if (column > 0)
+            cells[count++] = blank - 1;
+        if (column < columns - 1)
+            cells[count++] = blank + 1;
+
+        if (count == 0)
+            break;
+
+        int next;
+        do
+            next = cells[g_rand_int_range(generator->rand, 0, count)];
+        while (next == previous && count > 1);
+
+        from[blank] = from[next];
+        from[next] = 0;
+        previous = blank;
+        blank = next;
+    }
+
+    return snps_game_new(rows, columns, from, generator->goal);
+}
+
+extern snps_game_t *snps_generator_permutation(snps_generator_t *generator)
+{
+    unsigned size = generator->size;
+    unsigned char from[size];
+
+    memcpy(from, generator->goal, size);
+
+    for (int i = size - 1; i > 0; --i) {
+        int j = g_rand_int_range(generator->rand, 0, i + 1);
+        unsigned char tile = from[i];
+        from[i] = from[j];
+        from[j] = tile;
+    }
+
+    snps_game_t *game = snps_game_new(generator->rows, generator->columns,
+        from, generator->goal);
+
+    if (snps_game_solvable(game))
+        return game;
+
+    /* swapping two tiles flips the parity of the permutation and with it
+       whether the goal board can be reached, except on boards of a single
+       row or column, where a long walk has to do */
+    unsigned i = from[0] == 0 ? 1 : 0, j = i + 1;
+    if (j < size && from[j] == 0)
+        ++j;
+
+    snps_game_free(game);
+
+    if (generator->rows == 1 || generator->columns == 1 || j >= size)
+        return snps_generator_walk(generator, 3 * size * size);
+
+    unsigned char tile = from[i];
+    from[i] = from[j];
+    from[j] = tile;
+
+    return snps_game_new(generator->rows, generator->columns, from,
+        generator->goal);
+}
+
+extern int snps_board_parse(const char *text, unsigned size,
+    unsigned char *board)
+{
+    unsigned count = 0;
+
+    if (strchr(text, ',') == NULL && strlen(text) == size) {
+        for (; count < size; ++count) {
+            char c = text[count];
+
+            if (c >= '0' && c <= '9')
+                board[count] = c - '0';
+            else if (c >= 'A' && c <= 'F')
+                board[count] = c - 'A' + 10;
+            else if (c >= 'a' && c <= 'f')
+                board[count] = c - 'a' + 10;
+            else
+                return -1;
+
+            if (board[count] >= size)
+                return -1;
+        }
+
+        return 0;
+    }
+
+    while (count < size) {
+        char *end;
+        unsigned long tile = strtoul(text, &end, 10);
+
+        if (end == text || tile >= size)
+            return -1;
+
+        board[count++] = tile;
+
+        if (*end != ',')
+            return *end == '\0' && count == size ? 0 : -1;
+        text = end + 1;
+    }
+
+    return -1;
+}
+
+extern void snps_board_format(const unsigned char *board, unsigned size,
+    char *text)
+{
+    for (int i = 0; i < size; ++i)
+        text += sprintf(text, i == 0 ? "%u" : ",%u", board[i]);
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,539 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+/* children are sent to their owners in batches of that many states and the
+   batches are sent at the latest after that many expansions */
+#define SNPS_HDA_BATCH 64
+#define SNPS_HDA_FLUSH 16
+#define SNPS_HDA_WEIGHT 2
+
+/* data types, a state is owned by the thread its hash selects, its parent
+   may be owned by another one, the blank of the parent is kept so the
+   children don't move back without looking at the parent */
+typedef struct {
+    guint32 parent;
+    unsigned g, h;
+    unsigned char parent_owner;
+    unsigned char blank;
+    unsigned char previous;
+    guint64 key[];
+} snps_hda_state_t;
+
+/* children sent to the thread owning them, the states follow each other
+   within messages */
+typedef struct snps_hda_batch {
+    struct snps_hda_batch *next;
+    unsigned count;
+    guint64 messages[];
+} snps_hda_batch_t;
+
+/* why a search ended before running out of states */
+enum {
+    SNPS_HDA_RUNNING,
+    SNPS_HDA_GOAL,
+    SNPS_HDA_PERIMETER,
+    SNPS_HDA_MEMORY,
+    SNPS_HDA_BUDGET,
+};
+
+typedef struct snps_hda snps_hda_t;
+
+typedef struct {
+    snps_hda_t *hda;
+    unsigned id;
+    snps_pool_t *pool;
+    snps_set_t *set;
+    snps_queue_t *open;
+    /* the batches sent by other threads, a stack which they push to without
+       a lock and which is taken as a whole by the owner */
+    snps_hda_batch_t *inbox;
+    /* the batch being filled for every other thread */
+    snps_hda_batch_t **outbox;
+    unsigned expansions;
+    snps_stats_t stats;
+} snps_hda_thread_t;
+
+struct snps_hda {
+    snps_game_t *game;
+    snps_packing_t packing;
+    guint64 *goal;
+    gsize state_size;
+    unsigned threads;
+    snps_hda_thread_t *workers;
+    snps_budget_t *budget;
+    /* the states open or on their way to their owner, no state is left
+       once it drops to zero as a thread only lowers it after counting the
+       children of a state */
+    gint work;
+    /* set once a thread ends the search, which is about the state end of
+       the thread with id owner */
+    gint reason;
+    unsigned owner;
+    guint32 end;
+};
+
+/* prototypes */
+static gpointer snps_hda_worker(gpointer data);
+static int snps_hda_expand(snps_hda_thread_t *thread, guint32 index);
+static void snps_hda_insert(snps_hda_thread_t *thread,
+    const snps_hda_state_t *state);
+static void snps_hda_post(snps_hda_thread_t *thread, unsigned owner,
+    const snps_hda_state_t *state);
+static void snps_hda_send(snps_hda_t *hda, unsigned owner,
+    snps_hda_batch_t *batch);
+static void snps_hda_flush(snps_hda_thread_t *thread);
+static void snps_hda_receive(snps_hda_thread_t *thread);
+static void snps_hda_stop(snps_hda_thread_t *thread, int reason,
+    guint32 index);
+static unsigned snps_hda_owner(snps_hda_t *hda, const guint64 *key);
+static snps_hda_state_t *snps_hda_state(snps_hda_t *hda, unsigned owner,
+    guint32 index);
+static snps_route_t *snps_hda_route(snps_hda_t *hda);
+
+extern snps_route_t *snps_run_fast_parallel(snps_game_t *game,
+    unsigned threads, snps_budget_t *budget, snps_stats_t *stats)
+{
+    snps_hda_t hda = {
+        .game = game,
+        .threads = MIN(threads == 0 ? g_get_num_processors() : threads, 255),
+        .budget = budget,
+        .work = 1,
+        .reason = SNPS_HDA_RUNNING,
+    };
+    snps_stats_t counters = {0, 1, 0, 0.0};
+    snps_route_t *route = NULL;
+
+    snps_packing_init(&hda.packing, game->size);
+    hda.state_size = sizeof(snps_hda_state_t) +
+        hda.packing.words * sizeof(guint64);
+    hda.goal = g_new(guint64, hda.packing.words);
+    snps_key_pack(&hda.packing, hda.goal, game->to);
+
+    hda.workers = g_new0(snps_hda_thread_t, hda.threads);
+    for (int i = 0; i < hda.threads; ++i) {
+        snps_hda_thread_t *thread = hda.workers + i;
+        thread->hda = &hda;
+        thread->id = i;
+        thread->pool = snps_pool_new();
+        snps_pool_reset(thread->pool, hda.state_size);
+        thread->set = snps_set_new(thread->pool,
+            G_STRUCT_OFFSET(snps_hda_state_t, key));
+        snps_set_reset(thread->set, hda.packing.words);
+        thread->set->profile = &thread->stats.profile;
+        thread->open = snps_queue_new();
+        thread->open->profile = &thread->stats.profile;
+        thread->outbox = g_new0(snps_hda_batch_t *, hda.threads);
+    }
+
+    /* the start state is handed to its owner before any thread runs */
+    guint64 buffer[hda.state_size / sizeof(guint64) + 1];
+    snps_hda_state_t *start = (snps_hda_state_t *) buffer;
+    start->parent = SNPS_NONE;
+    start->g = 0;
+    start->h = snps_heuristic(game, game->from);
+    start->blank = 0;
+    while (game->from[start->blank] != 0)
+        ++start->blank;
+    start->previous = start->blank;
+    start->parent_owner = 0;
+    snps_key_pack(&hda.packing, start->key, game->from);
+    snps_hda_insert(hda.workers + snps_hda_owner(&hda, start->key), start);
+    SNPS_PROFILE_ADD(&counters.profile, estimates, 1);
+
+    /* the calling thread works as well */
+    GThread **workers = g_new(GThread *, hda.threads);
+    for (int i = 1; i < hda.threads; ++i)
+        workers[i] = g_thread_new("snps-hda", snps_hda_worker,
+            hda.workers + i);
+
+    snps_hda_worker(hda.workers);
+
+    for (int i = 1; i < hda.threads; ++i)
+        g_thread_join(workers[i]);
+
+    g_free(workers);
+
+    for (int i = 0; i < hda.threads; ++i) {
+        snps_hda_thread_t *thread = hda.workers + i;
+
+        counters.compared += thread->stats.compared;
+        counters.expanded += thread->stats.expanded;
+        counters.depth = MAX(counters.depth, thread->stats.depth);
+        SNPS_PROFILE_PEAK(&thread->stats.profile, closed_peak,
+            thread->set->count);
+        SNPS_PROFILE_ADD(&thread->stats.profile, bytes,
+            (gsize) thread->pool->count * thread->pool->item_size);
+        snps_profile_add(&counters.profile, &thread->stats.profile);
+    }
+
+    SNPS_PROFILE_START(clock);
+
+    if (hda.reason == SNPS_HDA_GOAL) {
+        route = snps_hda_route(&hda);
+    } else if (hda.reason == SNPS_HDA_PERIMETER) {
+        snps_route_t *prefix = snps_hda_route(&hda);
+        unsigned count = prefix->length - 1;
+        char moves[count + game->perimeter->depth + 1];
+
+        snps_route_write_moves(prefix, moves);
+        count += snps_perimeter_moves(game,
+            snps_hda_state(&hda, hda.owner, hda.end)->key, moves + count);
+        snps_route_free(prefix);
+        route = snps_route_new_moves(game, moves, count);
+    }
+
+    SNPS_PROFILE_STOP(&counters.profile, route_seconds, clock);
+
+    /* out of memory the search goes on like the fast one from the state the
+       thread running out of it was about to expand */
+    if (hda.reason == SNPS_HDA_MEMORY) {
+        snps_route_t *prefix = snps_hda_route(&hda);
+        char moves[prefix->length];
+
+        snps_route_write_moves(prefix, moves);
+        route = snps_run_ida_from(game, moves, prefix->length - 1,
+            SNPS_HDA_WEIGHT, 0, NULL, budget, &counters);
+        snps_route_free(prefix);
+    }
+
+    for (int i = 0; i < hda.threads; ++i) {
+        snps_hda_thread_t *thread = hda.workers + i;
+        snps_hda_batch_t *batch = thread->inbox;
+
+        while (batch != NULL) {
+            snps_hda_batch_t *next = batch->next;
+            g_free(batch);
+            batch = next;
+        }
+
+        for (int j = 0; j < hda.threads; ++j)
+            g_free(thread->outbox[j]);
+
+        g_free(thread->outbox);
+        snps_queue_free(thread->open);
+        snps_set_free(thread->set);
+        snps_pool_free(thread->pool);
+    }
+
+    g_free(hda.workers);
+    g_free(hda.goal);
+
+    if (stats != NULL)
+        *stats = counters;
+
+    return route;
+}
+
+/* expand the open states of a thread and the states sent to it until a
+   thread ends the search or no state is left anywhere, an idle thread keeps
+   looking for states sent to it */
+static gpointer snps_hda_worker(gpointer data)
+{
+    snps_hda_thread_t *thread = (snps_hda_thread_t *) data;
+    snps_hda_t *hda = thread->hda;
+    snps_perimeter_t *perimeter = hda->game->perimeter;
+    gsize memory_limit = hda->game->memory_limit / hda->threads;
+
+    while (g_atomic_int_get(&hda->reason) == SNPS_HDA_RUNNING) {
+        snps_hda_receive(thread);
+
+        guint32 index = snps_queue_pop(thread->open);
+
+        if (index == SNPS_NONE) {
+            snps_hda_flush(thread);
+            if (g_atomic_int_get(&hda->work) == 0)
+                break;
+            g_thread_yield();
+            continue;
+        }
+
+        snps_hda_state_t *current = snps_hda_state(hda, thread->id, index);
+
+        thread->stats.depth = MAX(thread->stats.depth, current->g);
+
+        if (snps_budget_stop(hda->budget, ++thread->stats.compared)) {
+            snps_hda_stop(thread, SNPS_HDA_BUDGET, SNPS_NONE);
+            break;
+        }
+
+        if (perimeter == NULL && memcmp(current->key, hda->goal,
+            hda->packing.words * sizeof(guint64)) == 0) {
+            snps_hda_stop(thread, SNPS_HDA_GOAL, index);
+            break;
+        }
+
+        if (perimeter != NULL && current->h <= perimeter->depth &&
+            snps_perimeter_distance(perimeter, current->key) != G_MAXUINT) {
+            snps_hda_stop(thread, SNPS_HDA_PERIMETER, index);
+            break;
+        }
+
+        /* every thread gets its share of the memory */
+        if (memory_limit != 0 && (gsize) thread->pool->count *
+            thread->pool->item_size + 2 * thread->set->count *
+            sizeof(snps_slot_t) + thread->open->count * sizeof(guint32) >=
+            memory_limit) {
+            snps_hda_stop(thread, SNPS_HDA_MEMORY, index);
+            break;
+        }
+
+        SNPS_PROFILE_START(clock);
+        thread->stats.expanded += snps_hda_expand(thread, index);
+        SNPS_PROFILE_STOP(&thread->stats.profile, expand_seconds, clock);
+
+        if (++thread->expansions % SNPS_HDA_FLUSH == 0)
+            snps_hda_flush(thread);
+    }
+
+    return NULL;
+}
+
+/* create the children of a state, which are opened right away if the
+   thread owns them and posted to their owner otherwise, the work is only
+   lowered for the state after counting its children so it can't drop to
+   zero while they are on their way */
+static int snps_hda_expand(snps_hda_thread_t *thread, guint32 index)
+{
+    snps_hda_t *hda = thread->hda;
+    snps_game_t *game = hda->game;
+    snps_hda_state_t *parent = snps_hda_state(hda, thread->id, index);
+    unsigned words = hda->state_size / sizeof(guint64) + 1;
+    guint64 buffers[4][words];
+    unsigned char board[game->size];
+    unsigned owners[4];
+    int cells[4], posted = 0, count = 0;
+
+    snps_key_unpack(&hda->packing, parent->key, board);
+    snps_neighbours(game, parent->blank, cells);
+
+    for (int i = 0; i < 4; ++i) {
+        if (cells[i] < 0 || cells[i] == parent->previous)
+            continue;
+
+        snps_hda_state_t *child = (snps_hda_state_t *) buffers[posted];
+        memcpy(child->key, parent->key, hda->packing.words * sizeof(guint64));
+        snps_key_move(&hda->packing, child->key, parent->blank, cells[i]);
+
+        unsigned owner = snps_hda_owner(hda, child->key);
+        snps_slot_t *slot = NULL;
+
+        /* children of the thread itself are only kept if they are new */
+        if (owner == thread->id) {
+            slot = snps_set_slot(thread->set, child->key);
+            if (snps_set_item(thread->set, slot) != SNPS_NONE) {
+                SNPS_PROFILE_ADD(&thread->stats.profile, duplicates, 1);
+                continue;
+            }
+        }
+
+        child->parent = index;
+        child->g = parent->g + 1;
+        child->parent_owner = thread->id;
+        child->blank = cells[i];
+        child->previous = parent->blank;
+
+        SNPS_PROFILE_ADD(&thread->stats.profile, estimates, 1);
+        if (game->pdb == NULL) {
+            child->h = snps_heuristic_move(game, board, parent->h,
+                parent->blank, cells[i]);
+        } else {
+            board[parent->blank] = board[cells[i]];
+            board[cells[i]] = 0;
+            child->h = snps_heuristic(game, board);
+            board[cells[i]] = board[parent->blank];
+            board[parent->blank] = 0;
+        }
+
+        if (owner == thread->id) {
+            guint32 item = snps_pool_alloc(thread->pool);
+            memcpy(snps_pool_get(thread->pool, item), child, hda->state_size);
+            snps_set_fill(thread->set, slot, child->key, item);
+            snps_queue_push(thread->open, child->g + SNPS_HDA_WEIGHT *
+                child->h, child->h, item);
+        } else {
+            owners[posted++] = owner;
+        }
+
+        ++count;
+    }
+
+    g_atomic_int_add(&hda->work, count - 1);
+
+    for (int i = 0; i < posted; ++i)
+        snps_hda_post(thread, owners[i], (snps_hda_state_t *) buffers[i]);
+
+    return count;
+}
+
+/* open a state sent to its owner unless the owner knows it already, which
+   drops it from the work */
+static void snps_hda_insert(snps_hda_thread_t *thread,
+    const snps_hda_state_t *state)
+{
+    snps_slot_t *slot = snps_set_slot(thread->set, state->key);
+
+    if (snps_set_item(thread->set, slot) != SNPS_NONE) {
+        SNPS_PROFILE_ADD(&thread->stats.profile, duplicates, 1);
+        g_atomic_int_add(&thread->hda->work, -1);
+        return;
+    }
+
+    guint32 item = snps_pool_alloc(thread->pool);
+    memcpy(snps_pool_get(thread->pool, item), state, thread->hda->state_size);
+    snps_set_fill(thread->set, slot, state->key, item);
+    snps_queue_push(thread->open, state->g + SNPS_HDA_WEIGHT * state->h,
+        state->h, item);
+}
+
+/* add a state to the batch for its owner, which is sent once it's full */
+static void snps_hda_post(snps_hda_thread_t *thread, unsigned owner,
+    const snps_hda_state_t *state)
+{
+    snps_hda_t *hda = thread->hda;
+    snps_hda_batch_t *batch = thread->outbox[owner];
+
+    if (batch == NULL) {
+        batch = thread->outbox[owner] = g_malloc(sizeof(snps_hda_batch_t) +
+            SNPS_HDA_BATCH * hda->state_size);
+        batch->count = 0;
+    }
+
+    memcpy((char *) batch->messages + batch->count++ * hda->state_size,
+        state, hda->state_size);
+
+    if (batch->count == SNPS_HDA_BATCH) {
+        snps_hda_send(hda, owner, batch);
+        thread->outbox[owner] = NULL;
+    }
+}
+
+/* push a batch onto the stack of its owner */
+static void snps_hda_send(snps_hda_t *hda, unsigned owner,
+    snps_hda_batch_t *batch)
+{
+    snps_hda_thread_t *target = hda->workers + owner;
+    snps_hda_batch_t *head;
+
+    do {
+        head = g_atomic_pointer_get(&target->inbox);
+        batch->next = head;
+    } while (!g_atomic_pointer_compare_and_exchange(&target->inbox, head,
+        batch));
+}
+
+/* send all batches of a thread which aren't full yet */
+static void snps_hda_flush(snps_hda_thread_t *thread)
+{
+    snps_hda_t *hda = thread->hda;
+
+    for (int i = 0; i < hda->threads; ++i)
+        if (thread->outbox[i] != NULL) {
+            snps_hda_send(hda, i, thread->outbox[i]);
+            thread->outbox[i] = NULL;
+        }
+}
+
+/* take all batches sent to a thread and open their states */
+static void snps_hda_receive(snps_hda_thread_t *thread)
+{
+    snps_hda_t *hda = thread->hda;
+    snps_hda_batch_t *batch;
+
+    /* only the owner takes batches, so a batch on top of the stack stays
+       there until it's taken */
+    do {
+        batch = g_atomic_pointer_get(&thread->inbox);
+    } while (batch != NULL && !g_atomic_pointer_compare_and_exchange(
+        &thread->inbox, batch, NULL));
+
+    while (batch != NULL) {
+        snps_hda_batch_t *next = batch->next;
+
+        for (unsigned i = 0; i < batch->count; ++i)
+            snps_hda_insert(thread, (snps_hda_state_t *) ((char *)
+                batch->messages + i * hda->state_size));
+
+        g_free(batch);
+        batch = next;
+    }
+}
+
+/* end the search at a state of a thread unless another thread did so */
+static void snps_hda_stop(snps_hda_thread_t *thread, int reason,
+    guint32 index)
+{
+    snps_hda_t *hda = thread->hda;
+
+    /* the state is only looked at once all threads are joined */
+    if (g_atomic_int_compare_and_exchange(&hda->reason, SNPS_HDA_RUNNING,
+        reason)) {
+        hda->owner = thread->id;
+        hda->end = index;
+    }
+}
+
+/* the thread owning a board, chosen by the upper bits of its hash as the
+   sets use the lower ones */
+static unsigned snps_hda_owner(snps_hda_t *hda, const guint64 *key)
+{
+    guint64 hash = snps_key_hash(key, hda->packing.words);
+
+    return ((hash >> 32) * hda->threads) >> 32;
+}
+
+/* the state at an index of the pool of a thread */
+static snps_hda_state_t *snps_hda_state(snps_hda_t *hda, unsigned owner,
+    guint32 index)
+{
+    return (snps_hda_state_t *) snps_pool_get(hda->workers[owner].pool,
+        index);
+}
+
+/* the route to the state which ended the search, following the parents
+   through the pools of their owners */
+static snps_route_t *snps_hda_route(snps_hda_t *hda)
+{
+    snps_hda_state_t *state = snps_hda_state(hda, hda->owner, hda->end);
+    unsigned count = state->g;
+    snps_route_t *route = snps_route_alloc(hda->game, hda->game->from,
+        count);
+
+    for (unsigned i = count; i > 0; --i) {
+        snps_route_set_move(route, i - 1, snps_route_direction(hda->game,
+            state->previous, state->blank));
+        state = snps_hda_state(hda, state->parent_owner, state->parent);
+    }
+
+    snps_route_complete(hda->game, route);
+
+    return route;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,130 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "snps_private.h"
+
+#include <stdlib.h>
+
+#include <glib.h>
+
+extern void snps_heuristic_init(snps_game_t *game)
+{
+    unsigned size = game->size;
+
+    /* the vector instructions read 32 bytes of the tables at once */
+    unsigned padded = MAX(size, 32);
+
+    game->distances = g_malloc0(size * size);
+    game->goal_rows = g_malloc0(padded);
+    game->goal_columns = g_malloc0(padded);
+    game->cell_rows = g_malloc0(padded);
+    game->cell_columns = g_malloc0(padded);
+
+    for (int i = 0; i < size; ++i) {
+        game->cell_rows[i] = TRANSLATE_1D_TO_ROW(i, game->columns);
+        game->cell_columns[i] = TRANSLATE_1D_TO_COLUMN(i, game->columns);
+    }
+
+    /* malformed goal boards are rejected by the solvers later on */
+    for (int i = 0; i < size; ++i) {
+        if (game->to[i] >= size)
+            continue;
+        game->goal_rows[game->to[i]] = TRANSLATE_1D_TO_ROW(i, game->columns);
+        game->goal_columns[game->to[i]] = TRANSLATE_1D_TO_COLUMN(i,
+            game->columns);
+    }
+
+    for (int tile = 1; tile < size; ++tile)
+        for (int i = 0; i < size; ++i)
+            game->distances[tile * size + i] =
+                abs(TRANSLATE_1D_TO_ROW(i, game->columns) -
+                    game->goal_rows[tile]) +
+                abs(TRANSLATE_1D_TO_COLUMN(i, game->columns) -
+                    game->goal_columns[tile]);
+}
+
+extern void snps_heuristic_clear(snps_game_t *game)
+{
+    g_free(game->cell_columns);
+    g_free(game->cell_rows);
+    g_free(game->goal_columns);
+    g_free(game->goal_rows);
+    g_free(game->distances);
+}
+
+extern unsigned snps_heuristic(snps_game_t *game, const unsigned char *board)
+{
+    if (game->pdb != NULL)
+        return snps_pdb_heuristic(game->pdb, board);
+
+    unsigned h = snps_simd_ops->manhattan(game, board);
+
+    if (game->linear_conflict) {
+        for (int row = 0; row < game->rows; ++row)
+            h += snps_conflicts_row(game, board, row, game->columns);
+        for (int column = 0; column < game->columns; ++column)
+            h += snps_conflicts_column(game, board, column, game->rows,
+                game->columns);
+    }
+
+    return h;
+}
+
+extern int snps_conflicts_move(snps_game_t *game, unsigned char *board,
+    unsigned p, unsigned q)
+{
+    unsigned rows = game->rows, columns = game->columns;
+    unsigned p_row = TRANSLATE_1D_TO_ROW(p, columns);
+    unsigned q_row = TRANSLATE_1D_TO_ROW(q, columns);
+    int delta = 0;
+
+    /* a horizontal move keeps the order of the tiles within the row, so
+       only the two columns are affected, and vice versa */
+    if (p_row == q_row) {
+        unsigned p_column = TRANSLATE_1D_TO_COLUMN(p, columns);
+        unsigned q_column = TRANSLATE_1D_TO_COLUMN(q, columns);
+
+        delta -= snps_conflicts_column(game, board, p_column, rows, columns) +
+            snps_conflicts_column(game, board, q_column, rows, columns);
+        board[p] = board[q];
+        board[q] = 0;
+        delta += snps_conflicts_column(game, board, p_column, rows, columns) +
+            snps_conflicts_column(game, board, q_column, rows, columns);
+    } else {
+        delta -= snps_conflicts_row(game, board, p_row, columns) +
+            snps_conflicts_row(game, board, q_row, columns);
+        board[p] = board[q];
+        board[q] = 0;
+        delta += snps_conflicts_row(game, board, p_row, columns) +
+            snps_conflicts_row(game, board, q_row, columns);
+    }
+
+    board[q] = board[p];
+    board[p] = 0;
+
+    return delta;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,523 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "snps_private.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#define SNPS_IDA_TASKS_PER_THREAD 16
+
+/* data types */
+typedef struct snps_ida snps_ida_t;
+
+typedef gboolean (*snps_ida_search_f)(snps_ida_t *ida, unsigned p,
+    unsigned g, unsigned h, char last);
+
+struct snps_ida {
+    snps_game_t *game;
+    snps_stats_f callback;
+    /* the depth first search of the kernel of the game */
+    snps_ida_search_f search;
+    snps_perimeter_t *perimeter;
+    unsigned char *board;
+    unsigned char *positions;
+    unsigned *patterns;
+    char *moves;
+    unsigned bound, next_bound, length;
+    /* the heuristic counts that many times, above 1 it's no longer optimal */
+    unsigned weight;
+    snps_stats_t stats;
+    snps_budget_t *budget;
+    gboolean stopped;
+    /* splitting stops at this depth and records the subtrees as tasks */
+    unsigned split;
+    GArray *tasks;
+    GArray *prefixes;
+    /* a task is abandoned once a task with a lower index found a route */
+    int task;
+    gint *solved;
+};
+
+typedef struct {
+    unsigned offset;
+    unsigned depth;
+    char last;
+} snps_task_t;
+
+typedef struct {
+    GMutex lock;
+    unsigned *tasks;
+    unsigned top, bottom;
+} snps_deque_t;
+
+typedef struct {
+    snps_game_t *game;
+    snps_budget_t *budget;
+    unsigned bound;
+    unsigned threads;
+    GArray *tasks;
+    GArray *prefixes;
+    snps_deque_t *deques;
+    gint solved;
+    GMutex lock;
+    char *moves;
+    unsigned length;
+    unsigned next_bound;
+    snps_stats_t stats;
+} snps_pida_t;
+
+typedef struct {
+    snps_pida_t *pida;
+    unsigned id;
+} snps_worker_t;
+
+/* prototypes */
+static void snps_ida_init(snps_ida_t *ida, snps_game_t *game,
+    snps_stats_f callback, snps_budget_t *budget);
+static void snps_ida_clear(snps_ida_t *ida);
+static unsigned snps_ida_reset(snps_ida_t *ida, const char *moves,
+    unsigned count, unsigned *h);
+static void snps_ida_task(snps_ida_t *ida, unsigned g, char last);
+static gboolean snps_ida_search(snps_ida_t *ida, unsigned p, unsigned g,
+    unsigned h, char last);
+static gboolean snps_ida_search_3x3(snps_ida_t *ida, unsigned p,
+    unsigned g, unsigned h, char last);
+static gboolean snps_ida_search_4x4(snps_ida_t *ida, unsigned p,
+    unsigned g, unsigned h, char last);
+static gboolean snps_ida_search_5x5(snps_ida_t *ida, unsigned p,
+    unsigned g, unsigned h, char last);
+static void snps_pida_split(snps_pida_t *pida, unsigned p, unsigned h);
+static gpointer snps_pida_worker(gpointer data);
+static gboolean snps_pida_take(snps_pida_t *pida, unsigned id,
+    unsigned *task);
+static void snps_stats_add(snps_stats_t *stats, const snps_stats_t *other);
+
+/* the depth first search of every kernel */
+static const snps_ida_search_f snps_ida_searches[] = {
+    [SNPS_KERNEL_GENERIC] = snps_ida_search,
+    [SNPS_KERNEL_3X3] = snps_ida_search_3x3,
+    [SNPS_KERNEL_4X4] = snps_ida_search_4x4,
+    [SNPS_KERNEL_5X5] = snps_ida_search_5x5,
+};
+
+extern snps_route_t *snps_run_ida(snps_game_t *game, snps_stats_f callback,
+    snps_budget_t *budget, snps_stats_t *stats)
+{
+    snps_stats_t counters = {0, 1, 0, 0.0};
+    snps_route_t *route = snps_run_ida_from(game, NULL, 0, 1, 0, callback,
+        budget, &counters);
+
+    if (stats != NULL)
+        *stats = counters;
+
+    return route;
+}
+
+extern snps_route_t *snps_run_ida_from(snps_game_t *game, const char *moves,
+    unsigned count, unsigned weight, unsigned bound, snps_stats_f callback,
+    snps_budget_t *budget, snps_stats_t *stats)
+{
+    snps_ida_t ida;
+    snps_ida_init(&ida, game, callback, budget);
+    ida.weight = weight;
+    ida.stats = *stats;
+
+    unsigned h;
+    unsigned p = snps_ida_reset(&ida, moves, count, &h);
+    snps_route_t *route = NULL;
+    ida.bound = MAX(bound, count + weight * h);
+    ida.moves = g_malloc(ida.bound + 1);
+    if (count > 0)
+        memcpy(ida.moves, moves, count);
+
+    while (42) {
+        ida.next_bound = G_MAXUINT;
+        ida.moves = g_realloc(ida.moves, ida.bound + 1);
+
+        SNPS_PROFILE_START(clock);
+        gboolean found = ida.search(&ida, p, count, h,
+            count > 0 ? moves[count - 1] : '\0');
+        SNPS_PROFILE_STOP(&ida.stats.profile, expand_seconds, clock);
+
+        if (found == TRUE) {
+            SNPS_PROFILE_START(route_clock);
+            route = snps_route_new_moves(game, ida.moves, ida.length);
+            SNPS_PROFILE_STOP(&ida.stats.profile, route_seconds,
+                route_clock);
+            break;
+        }
+
+        if (ida.stopped || ida.next_bound == G_MAXUINT)
+            break;
+
+        ida.bound = ida.next_bound;
+    }
+
+    *stats = ida.stats;
+    snps_ida_clear(&ida);
+
+    return route;
+}
+
+extern snps_route_t *snps_run_ida_parallel(snps_game_t *game,
+    unsigned threads, snps_budget_t *budget, snps_stats_t *stats)
+{
+    snps_pida_t pida = {
+        .game = game,
+        .budget = budget,
+        .threads = threads == 0 ? g_get_num_processors() : threads,
+        .tasks = g_array_new(FALSE, FALSE, sizeof(snps_task_t)),
+        .prefixes = g_array_new(FALSE, FALSE, sizeof(char)),
+        .moves = NULL,
+        .stats = {0, 0, 0, 0.0},
+    };
+
+    g_mutex_init(&pida.lock);
+    pida.deques = g_new0(snps_deque_t, pida.threads);
+    for (int i = 0; i < pida.threads; ++i)
+        g_mutex_init(&pida.deques[i].lock);
+
+    GThread **workers = g_new(GThread *, pida.threads);
+    snps_worker_t *arguments = g_new(snps_worker_t, pida.threads);
+
+    snps_ida_t ida;
+    snps_ida_init(&ida, game, NULL, budget);
+
+    unsigned h;
+    unsigned p = snps_ida_reset(&ida, NULL, 0, &h);
+    snps_route_t *route = NULL;
+    snps_ida_clear(&ida);
+    pida.bound = h;
+
+    while (42) {
+        pida.solved = G_MAXINT;
+        pida.next_bound = G_MAXUINT;
+        snps_pida_split(&pida, p, h);
+
+        /* every thread starts with a contiguous block of tasks and steals
+           from the end of the others once its own are done */
+        for (int i = 0; i < pida.threads; ++i) {
+            snps_deque_t *deque = pida.deques + i;
+            unsigned first = (guint64) pida.tasks->len * i / pida.threads;
+            unsigned last = (guint64) pida.tasks->len * (i + 1) /
+                pida.threads;
+
+            deque->tasks = g_renew(unsigned, deque->tasks, last - first + 1);
+            deque->top = 0;
+            deque->bottom = last - first;
+            for (unsigned j = first; j < last; ++j)
+                deque->tasks[j - first] = j;
+        }
+
+        for (int i = 0; i < pida.threads; ++i) {
+            arguments[i].pida = &pida;
+            arguments[i].id = i;
+            if (i > 0)
+                workers[i] = g_thread_new("snps-ida", snps_pida_worker,
+                    arguments + i);
+        }
+
+        snps_pida_worker(arguments);
+
+        for (int i = 1; i < pida.threads; ++i)
+            g_thread_join(workers[i]);
+
+        if (pida.solved != G_MAXINT) {
+            SNPS_PROFILE_START(clock);
+            route = snps_route_new_moves(game, pida.moves, pida.length);
+            SNPS_PROFILE_STOP(&pida.stats.profile, route_seconds, clock);
+            break;
+        }
+
+        if (g_atomic_int_get(&budget->status) != SNPS_STATUS_SOLVED ||
+            pida.next_bound == G_MAXUINT)
+            break;
+
+        pida.bound = pida.next_bound;
+    }
+
+    if (stats != NULL)
+        *stats = pida.stats;
+
+    for (int i = 0; i < pida.threads; ++i) {
+        g_mutex_clear(&pida.deques[i].lock);
+        g_free(pida.deques[i].tasks);
+    }
+
+    g_free(arguments);
+    g_free(workers);
+    g_free(pida.deques);
+    g_free(pida.moves);
+    g_array_free(pida.prefixes, TRUE);
+    g_array_free(pida.tasks, TRUE);
+    g_mutex_clear(&pida.lock);
+
+    return route;
+}
+
+/* allocate the buffers of a search */
+static void snps_ida_init(snps_ida_t *ida, snps_game_t *game,
+    snps_stats_f callback, snps_budget_t *budget)
+{
+    ida->game = game;
+    ida->callback = callback;
+    ida->search = snps_ida_searches[game->kernel];
+    ida->perimeter = game->perimeter;
+    ida->budget = budget;
+    ida->stopped = FALSE;
+    ida->board = g_slice_alloc(game->size);
+    ida->positions = g_slice_alloc(game->size);
+    ida->patterns = game->pdb == NULL ? NULL :
+        g_new(unsigned, game->pdb->count);
+    ida->moves = NULL;
+    ida->weight = 1;
+    ida->stats = (snps_stats_t) {0, 1, 0, 0.0};
+    ida->split = G_MAXUINT;
+    ida->tasks = NULL;
+    ida->prefixes = NULL;
+    ida->task = 0;
+    ida->solved = NULL;
+}
+
+/* free the buffers of a search */
+static void snps_ida_clear(snps_ida_t *ida)
+{
+    g_free(ida->moves);
+    g_free(ida->patterns);
+    g_slice_free1(ida->game->size, ida->positions);
+    g_slice_free1(ida->game->size, ida->board);
+}
+
+/* start over at the start board and replay some moves of the blank, returns
+   the position of the blank and the estimated distance in h */
+static unsigned snps_ida_reset(snps_ida_t *ida, const char *moves,
+    unsigned count, unsigned *h)
+{
+    snps_game_t *game = ida->game;
+    memcpy(ida->board, game->from, game->size);
+
+    unsigned p = 0;
+    while (ida->board[p] != 0)
+        ++p;
+
+    for (int i = 0; i < count; ++i) {
+        unsigned q = p;
+
+        switch (moves[i]) {
+            case 'L': q -= 1; break;
+            case 'R': q += 1; break;
+            case 'U': q -= game->columns; break;
+            case 'D': q += game->columns; break;
+        }
+
+        ida->board[p] = ida->board[q];
+        ida->board[q] = 0;
+        p = q;
+    }
+
+    for (int i = 0; i < game->size; ++i)
+        ida->positions[ida->board[i]] = i;
+
+    /* with a pattern database every pattern keeps its own distance, so a
+       move only requires a lookup for the pattern of the moved tile */
+    if (game->pdb != NULL)
+        for (int i = 0; i < game->pdb->count; ++i)
+            ida->patterns[i] = snps_pdb_pattern(game->pdb, i,
+                ida->positions);
+
+    *h = snps_heuristic(game, ida->board);
+    SNPS_PROFILE_ADD(&ida->stats.profile, estimates, 1);
+
+    return p;
+}
+
+/* record the subtree below the current board as a task of the split */
+static void snps_ida_task(snps_ida_t *ida, unsigned g, char last)
+{
+    snps_task_t task = {ida->prefixes->len, g, last};
+    g_array_append_val(ida->tasks, task);
+    g_array_append_vals(ida->prefixes, ida->moves, g);
+}
+
+/* the searches of every kernel, the generic one reads the size of the
+   board from the game */
+#define SNPS_KERNEL_SEARCH snps_ida_search
+#include "ida_search.h"
+
+#define SNPS_KERNEL_SEARCH snps_ida_search_3x3
+#define SNPS_KERNEL_CONFLICTS snps_ida_conflicts_3x3
+#define SNPS_KERNEL_ROWS 3
+#define SNPS_KERNEL_COLUMNS 3
+#define SNPS_KERNEL_NEIGHBOURS snps_neighbours_3x3
+#include "ida_search.h"
+
+#define SNPS_KERNEL_SEARCH snps_ida_search_4x4
+#define SNPS_KERNEL_CONFLICTS snps_ida_conflicts_4x4
+#define SNPS_KERNEL_ROWS 4
+#define SNPS_KERNEL_COLUMNS 4
+#define SNPS_KERNEL_NEIGHBOURS snps_neighbours_4x4
+#include "ida_search.h"
+
+#define SNPS_KERNEL_SEARCH snps_ida_search_5x5
+#define SNPS_KERNEL_CONFLICTS snps_ida_conflicts_5x5
+#define SNPS_KERNEL_ROWS 5
+#define SNPS_KERNEL_COLUMNS 5
+#define SNPS_KERNEL_NEIGHBOURS snps_neighbours_5x5
+#include "ida_search.h"
+
+/* split the tree of the current iteration into subtrees in the order the
+   sequential search visits them, deepening the split until there are
+   enough tasks to keep all threads busy */
+static void snps_pida_split(snps_pida_t *pida, unsigned p, unsigned h)
+{
+    snps_ida_t ida;
+    snps_ida_init(&ida, pida->game, NULL, pida->budget);
+    snps_ida_reset(&ida, NULL, 0, &h);
+
+    ida.bound = pida->bound;
+    ida.moves = g_malloc(pida->bound + 1);
+    ida.tasks = pida->tasks;
+    ida.prefixes = pida->prefixes;
+    ida.stats.expanded = 0;
+
+    for (ida.split = 1; ; ++ida.split) {
+        g_array_set_size(ida.tasks, 0);
+        g_array_set_size(ida.prefixes, 0);
+        ida.next_bound = G_MAXUINT;
+
+        SNPS_PROFILE_START(clock);
+        ida.search(&ida, p, 0, h, '\0');
+        SNPS_PROFILE_STOP(&ida.stats.profile, expand_seconds, clock);
+
+        if (ida.stopped ||
+            ida.tasks->len >= SNPS_IDA_TASKS_PER_THREAD * pida->threads ||
+            ida.split >= pida->bound)
+            break;
+    }
+
+    pida->next_bound = ida.next_bound;
+    snps_stats_add(&pida->stats, &ida.stats);
+    snps_ida_clear(&ida);
+}
+
+/* search the subtrees of tasks until none is left */
+static gpointer snps_pida_worker(gpointer data)
+{
+    snps_worker_t *worker = (snps_worker_t *) data;
+    snps_pida_t *pida = worker->pida;
+    unsigned index;
+
+    snps_ida_t ida;
+    snps_ida_init(&ida, pida->game, NULL, pida->budget);
+
+    ida.bound = pida->bound;
+    ida.next_bound = G_MAXUINT;
+    ida.moves = g_malloc(pida->bound + 1);
+    ida.solved = &pida->solved;
+    ida.stats.expanded = 0;
+
+    while (ida.stopped == FALSE &&
+        snps_pida_take(pida, worker->id, &index) == TRUE) {
+        if (g_atomic_int_get(&pida->solved) < index)
+            continue;
+
+        snps_task_t *task = &g_array_index(pida->tasks, snps_task_t, index);
+        const char *prefix = &g_array_index(pida->prefixes, char,
+            task->offset);
+        unsigned h;
+        unsigned p = snps_ida_reset(&ida, prefix, task->depth, &h);
+
+        if (task->depth > 0)
+            memcpy(ida.moves, prefix, task->depth);
+        ida.task = index;
+
+        SNPS_PROFILE_START(clock);
+        gboolean found = ida.search(&ida, p, task->depth, h,
+            task->last);
+        SNPS_PROFILE_STOP(&ida.stats.profile, expand_seconds, clock);
+
+        if (found == FALSE)
+            continue;
+
+        /* keep the route of the first task in the sequential order */
+        g_mutex_lock(&pida->lock);
+        if (index < pida->solved) {
+            pida->moves = g_realloc(pida->moves, ida.length);
+            if (ida.length > 0)
+                memcpy(pida->moves, ida.moves, ida.length);
+            pida->length = ida.length;
+            g_atomic_int_set(&pida->solved, index);
+        }
+        g_mutex_unlock(&pida->lock);
+    }
+
+    g_mutex_lock(&pida->lock);
+    if (ida.next_bound < pida->next_bound)
+        pida->next_bound = ida.next_bound;
+    snps_stats_add(&pida->stats, &ida.stats);
+    g_mutex_unlock(&pida->lock);
+
+    snps_ida_clear(&ida);
+
+    return NULL;
+}
+
+/* take the next task from the own deque or steal the last one of another
+   thread, returns FALSE if there is no task left */
+static gboolean snps_pida_take(snps_pida_t *pida, unsigned id,
+    unsigned *task)
+{
+    for (int i = 0; i < pida->threads; ++i) {
+        snps_deque_t *deque = pida->deques + (id + i) % pida->threads;
+        gboolean found = FALSE;
+
+        g_mutex_lock(&deque->lock);
+        if (deque->top < deque->bottom) {
+            *task = i == 0 ? deque->tasks[deque->top++] :
+                deque->tasks[--deque->bottom];
+            found = TRUE;
+        }
+        g_mutex_unlock(&deque->lock);
+
+        if (found == TRUE)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* accumulate the statistics of several searches */
+static void snps_stats_add(snps_stats_t *stats, const snps_stats_t *other)
+{
+    stats->compared += other->compared;
+    stats->expanded += other->expanded;
+    if (other->depth > stats->depth)
+        stats->depth = other->depth;
+    snps_profile_add(&stats->profile, &other->profile);
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,216 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* the depth first search of the iterative deepening, included by ida.c once
+   for every kernel, SNPS_KERNEL_SEARCH names the function and the board
+   size is taken from SNPS_KERNEL_ROWS, SNPS_KERNEL_COLUMNS and the table
+   SNPS_KERNEL_NEIGHBOURS, without them it's read from the game, kernels of
+   a fixed size also need a name for their SNPS_KERNEL_CONFLICTS */
+
+#ifdef SNPS_KERNEL_ROWS
+#define SNPS_KERNEL_SIZE (SNPS_KERNEL_ROWS * SNPS_KERNEL_COLUMNS)
+
+/* snps_conflicts_move with the lines of the board unrolled */
+static int SNPS_KERNEL_CONFLICTS(snps_game_t *game, unsigned char *board,
+    unsigned p, unsigned q)
+{
+    const unsigned rows = SNPS_KERNEL_ROWS, columns = SNPS_KERNEL_COLUMNS;
+    unsigned p_row = TRANSLATE_1D_TO_ROW(p, columns);
+    unsigned q_row = TRANSLATE_1D_TO_ROW(q, columns);
+    int delta = 0;
+
+    if (p_row == q_row) {
+        unsigned p_column = TRANSLATE_1D_TO_COLUMN(p, columns);
+        unsigned q_column = TRANSLATE_1D_TO_COLUMN(q, columns);
+
+        delta -= snps_conflicts_column(game, board, p_column, rows, columns) +
+            snps_conflicts_column(game, board, q_column, rows, columns);
+        board[p] = board[q];
+        board[q] = 0;
+        delta += snps_conflicts_column(game, board, p_column, rows, columns) +
+            snps_conflicts_column(game, board, q_column, rows, columns);
+    } else {
+        delta -= snps_conflicts_row(game, board, p_row, columns) +
+            snps_conflicts_row(game, board, q_row, columns);
+        board[p] = board[q];
+        board[q] = 0;
+        delta += snps_conflicts_row(game, board, p_row, columns) +
+            snps_conflicts_row(game, board, q_row, columns);
+    }
+
+    board[q] = board[p];
+    board[p] = 0;
+
+    return delta;
+}
+#else
+#define SNPS_KERNEL_SIZE game->size
+#define SNPS_KERNEL_CONFLICTS snps_conflicts_move
+#endif
+
+/* depth first search bounded by the current threshold of the iterative
+   deepening, the blank is located at p */
+static gboolean SNPS_KERNEL_SEARCH(snps_ida_t *ida, unsigned p, unsigned g,
+    unsigned h, char last)
+{
+    static const char directions[] = "LRUD";
+    static const char opposites[] = "RLDU";
+
+    snps_game_t *game = ida->game;
+    unsigned f = g + ida->weight * h;
+
+    ida->stats.depth = g;
+    if (ida->callback != NULL)
+        ida->callback(++ida->stats.compared, ida->stats.expanded, g);
+    else
+        ++ida->stats.compared;
+
+    if (ida->stopped || snps_budget_stop(ida->budget, ida->stats.compared)) {
+        ida->stopped = TRUE;
+        return FALSE;
+    }
+
+    if (f > ida->bound) {
+        if (f < ida->next_bound)
+            ida->next_bound = f;
+        return FALSE;
+    }
+
+    if (G_UNLIKELY(ida->split != G_MAXUINT) && (g == ida->split || h == 0)) {
+        snps_ida_task(ida, g, last);
+        return FALSE;
+    }
+
+    if (h == 0) {
+        ida->length = g;
+        return TRUE;
+    }
+
+    /* boards outside of the perimeter are further away than its depth,
+       which only matters close to the bound as no route is shorter than it,
+       and the exact distance of those within it completes the route */
+    if (ida->perimeter != NULL && h <= ida->perimeter->depth) {
+        unsigned distance = ida->perimeter->depth + 1;
+
+        /* the manhattan distance has the parity of the distance */
+        if (game->pdb == NULL && (distance - h) % 2 != 0)
+            ++distance;
+
+        if (g + ida->weight * distance > ida->bound) {
+            guint64 key[ida->perimeter->packing.words];
+            snps_key_pack(&ida->perimeter->packing, key, ida->board);
+            unsigned exact = snps_perimeter_distance(ida->perimeter, key);
+
+            f = g + ida->weight * MIN(distance, exact);
+            if (f > ida->bound) {
+                if (f < ida->next_bound)
+                    ida->next_bound = f;
+                return FALSE;
+            }
+
+            /* while splitting the board becomes a task, whose search
+               completes the route just like the sequential one */
+            if (exact != G_MAXUINT && G_UNLIKELY(ida->split != G_MAXUINT)) {
+                snps_ida_task(ida, g, last);
+                return FALSE;
+            }
+
+            if (exact != G_MAXUINT) {
+                ida->length = g + snps_perimeter_moves(ida->game, key,
+                    ida->moves + g);
+                return TRUE;
+            }
+        }
+    }
+
+    if (ida->solved != NULL && g_atomic_int_get(ida->solved) < ida->task)
+        return FALSE;
+
+#ifdef SNPS_KERNEL_NEIGHBOURS
+    const signed char *cells = SNPS_KERNEL_NEIGHBOURS[p];
+#else
+    int cells[4];
+    snps_neighbours(game, p, cells);
+#endif
+
+    for (int i = 0; i < 4; ++i) {
+        if (cells[i] < 0 || last == opposites[i])
+            continue;
+
+        /* the tile slides from q into the blank at p, so only its own
+           distance to the goal changes */
+        unsigned q = cells[i];
+        unsigned char tile = ida->board[q];
+        unsigned child_h, pattern = 0, pattern_h = 0;
+
+        ida->positions[tile] = p;
+
+        SNPS_PROFILE_START(clock);
+        SNPS_PROFILE_ADD(&ida->stats.profile, estimates, 1);
+
+        if (game->pdb == NULL) {
+            const unsigned char *distances = game->distances +
+                tile * SNPS_KERNEL_SIZE;
+            child_h = h + distances[p] - distances[q];
+
+            if (game->linear_conflict)
+                child_h += SNPS_KERNEL_CONFLICTS(game, ida->board, p, q);
+        } else {
+            pattern = game->pdb->partition[tile];
+            pattern_h = ida->patterns[pattern];
+            ida->patterns[pattern] = snps_pdb_pattern(game->pdb, pattern,
+                ida->positions);
+            child_h = h - pattern_h + ida->patterns[pattern];
+        }
+
+        SNPS_PROFILE_STOP(&ida->stats.profile, estimate_seconds, clock);
+
+        ida->board[p] = tile;
+        ida->board[q] = 0;
+        ida->moves[g] = directions[i];
+        ++ida->stats.expanded;
+
+        if (SNPS_KERNEL_SEARCH(ida, q, g + 1, child_h, directions[i]) ==
+            TRUE)
+            return TRUE;
+
+        ida->board[q] = tile;
+        ida->board[p] = 0;
+        ida->positions[tile] = q;
+
+        if (game->pdb != NULL)
+            ida->patterns[pattern] = pattern_h;
+    }
+
+    return FALSE;
+}
+
+#undef SNPS_KERNEL_SIZE
+#undef SNPS_KERNEL_CONFLICTS
+#undef SNPS_KERNEL_SEARCH
+#undef SNPS_KERNEL_ROWS
+#undef SNPS_KERNEL_COLUMNS
+#undef SNPS_KERNEL_NEIGHBOURS
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
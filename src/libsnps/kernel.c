@@ -0,0 +1,77 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <glib.h>
+
+/* the neighbours of cell p on a board of a size known at compile time */
+#define SNPS_NEIGHBOURS(p, rows, columns) { \
+    (p) % (columns) > 0 ? (p) - 1 : -1, \
+    (p) % (columns) < (columns) - 1 ? (p) + 1 : -1, \
+    (p) >= (columns) ? (p) - (columns) : -1, \
+    (p) < ((rows) - 1) * (columns) ? (p) + (columns) : -1}
+
+/* expand a macro for every cell of a board of up to 25 cells */
+#define SNPS_CELLS_9(X, r, c) X(0, r, c), X(1, r, c), X(2, r, c), \
+    X(3, r, c), X(4, r, c), X(5, r, c), X(6, r, c), X(7, r, c), X(8, r, c)
+#define SNPS_CELLS_16(X, r, c) SNPS_CELLS_9(X, r, c), X(9, r, c), \
+    X(10, r, c), X(11, r, c), X(12, r, c), X(13, r, c), X(14, r, c), \
+    X(15, r, c)
+#define SNPS_CELLS_25(X, r, c) SNPS_CELLS_16(X, r, c), X(16, r, c), \
+    X(17, r, c), X(18, r, c), X(19, r, c), X(20, r, c), X(21, r, c), \
+    X(22, r, c), X(23, r, c), X(24, r, c)
+
+const signed char snps_neighbours_3x3[9][4] = {
+    SNPS_CELLS_9(SNPS_NEIGHBOURS, 3, 3)
+};
+
+const signed char snps_neighbours_4x4[16][4] = {
+    SNPS_CELLS_16(SNPS_NEIGHBOURS, 4, 4)
+};
+
+const signed char snps_neighbours_5x5[25][4] = {
+    SNPS_CELLS_25(SNPS_NEIGHBOURS, 5, 5)
+};
+
+const signed char (*const snps_kernel_neighbours[])[4] = {
+    [SNPS_KERNEL_GENERIC] = NULL,
+    [SNPS_KERNEL_3X3] = snps_neighbours_3x3,
+    [SNPS_KERNEL_4X4] = snps_neighbours_4x4,
+    [SNPS_KERNEL_5X5] = snps_neighbours_5x5,
+};
+
+extern snps_kernel_t snps_kernel_select(unsigned rows, unsigned columns)
+{
+    if (rows == 3 && columns == 3)
+        return SNPS_KERNEL_3X3;
+    if (rows == 4 && columns == 4)
+        return SNPS_KERNEL_4X4;
+    if (rows == 5 && columns == 5)
+        return SNPS_KERNEL_5X5;
+
+    return SNPS_KERNEL_GENERIC;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,406 @@
+#define _POSIX_C_SOURCE 200809L
+
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "snps_private.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+
+#define SNPS_PDB_MAGIC "SNPSPDB"
+#define SNPS_PDB_VERSION 1
+#define SNPS_PDB_MAX_TILES 8
+#define SNPS_PDB_DEFAULT_TILES 6
+#define SNPS_PDB_NONE 0xff
+
+/* data type, the file starts with this header followed by the goal board,
+   the partition, padding up to 8 bytes and the tables in pattern order, all
+   stored in native byte order */
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 rows;
+    guint32 columns;
+    guint32 count;
+} snps_pdb_header_t;
+
+/* prototypes */
+static snps_pdb_t *snps_pdb_new(unsigned rows, unsigned columns,
+    const unsigned char *goal, const unsigned char *partition);
+static guint64 snps_pdb_entries(snps_pdb_t *pdb, unsigned pattern);
+static gsize snps_pdb_tables_offset(snps_pdb_t *pdb);
+static unsigned char *snps_pdb_build_pattern(snps_pdb_t *pdb,
+    snps_game_t *game, unsigned pattern);
+
+extern snps_pdb_t *snps_pdb_build(snps_game_t *game,
+    const unsigned char *partition)
+{
+    unsigned char defaults[game->size];
+
+    if (game->size > 64)
+        return NULL;
+
+    if (partition == NULL) {
+        for (int i = 1; i < game->size; ++i)
+            defaults[i] = (i - 1) / SNPS_PDB_DEFAULT_TILES;
+        defaults[0] = SNPS_PDB_NONE;
+        partition = defaults;
+    }
+
+    snps_pdb_t *pdb = snps_pdb_new(game->rows, game->columns, game->to,
+        partition);
+    if (pdb == NULL)
+        return NULL;
+
+    for (int i = 0; i < pdb->count; ++i)
+        pdb->tables[i] = snps_pdb_build_pattern(pdb, game, i);
+
+    return pdb;
+}
+
+extern int snps_pdb_save(snps_pdb_t *pdb, const char *filename)
+{
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+        return -1;
+
+    snps_pdb_header_t header = {
+        .magic = SNPS_PDB_MAGIC,
+        .version = SNPS_PDB_VERSION,
+        .rows = pdb->rows,
+        .columns = pdb->columns,
+        .count = pdb->count,
+    };
+
+    char padding[8] = {0};
+    gsize offset = snps_pdb_tables_offset(pdb);
+    gsize written = sizeof(header) + 2 * pdb->size;
+    int failed = 0;
+
+    failed |= fwrite(&header, sizeof(header), 1, file) != 1;
+    failed |= fwrite(pdb->goal, pdb->size, 1, file) != 1;
+    failed |= fwrite(pdb->partition, pdb->size, 1, file) != 1;
+    if (offset > written)
+        failed |= fwrite(padding, offset - written, 1, file) != 1;
+
+    for (int i = 0; i < pdb->count; ++i)
+        failed |= fwrite(pdb->tables[i], snps_pdb_entries(pdb, i), 1,
+            file) != 1;
+
+    failed |= fclose(file) != 0;
+
+    return failed ? -1 : 0;
+}
+
+extern snps_pdb_t *snps_pdb_load(snps_game_t *game, const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) (sizeof(snps_pdb_header_t)
+        + 2 * game->size)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return NULL;
+
+    snps_pdb_header_t *header = map;
+    unsigned char *goal = (unsigned char *) map + sizeof(*header);
+    unsigned char *partition = goal + game->size;
+    snps_pdb_t *pdb = NULL;
+
+    if (memcmp(header->magic, SNPS_PDB_MAGIC, sizeof(header->magic)) == 0 &&
+        header->version == SNPS_PDB_VERSION &&
+        header->rows == game->rows && header->columns == game->columns &&
+        memcmp(goal, game->to, game->size) == 0)
+        pdb = snps_pdb_new(game->rows, game->columns, goal, partition);
+
+    if (pdb == NULL || pdb->count != header->count) {
+        if (pdb != NULL)
+            snps_pdb_free(pdb);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    gsize offset = snps_pdb_tables_offset(pdb);
+    for (int i = 0; i < pdb->count; ++i) {
+        pdb->tables[i] = (unsigned char *) map + offset;
+        offset += snps_pdb_entries(pdb, i);
+    }
+
+    pdb->map = map;
+    pdb->map_length = st.st_size;
+
+    if (offset != (gsize) st.st_size) {
+        snps_pdb_free(pdb);
+        return NULL;
+    }
+
+    return pdb;
+}
+
+extern void snps_pdb_free(snps_pdb_t *pdb)
+{
+    if (pdb->map != NULL)
+        munmap(pdb->map, pdb->map_length);
+    else
+        for (int i = 0; i < pdb->count; ++i)
+            g_free(pdb->tables[i]);
+
+    g_free(pdb->tables);
+    g_free(pdb->offsets);
+    g_free(pdb->lengths);
+    g_free(pdb->tiles);
+    g_free(pdb->partition);
+    g_free(pdb->goal);
+    g_slice_free(snps_pdb_t, pdb);
+}
+
+extern unsigned snps_pdb_heuristic(const snps_pdb_t *pdb,
+    const unsigned char *board)
+{
+    unsigned char positions[pdb->size];
+    for (int i = 0; i < pdb->size; ++i)
+        positions[board[i]] = i;
+
+    unsigned h = 0;
+    for (int i = 0; i < pdb->count; ++i)
+        h += snps_pdb_pattern(pdb, i, positions);
+
+    return h;
+}
+
+extern unsigned snps_pdb_pattern(const snps_pdb_t *pdb, unsigned pattern,
+    const unsigned char *positions)
+{
+    unsigned char cells[SNPS_PDB_MAX_TILES];
+    const unsigned char *tiles = pdb->tiles + pdb->offsets[pattern];
+
+    for (int i = 0; i < pdb->lengths[pattern]; ++i)
+        cells[i] = positions[tiles[i]];
+
+    return pdb->tables[pattern][snps_rank(pdb->size,
+        pdb->lengths[pattern], cells)];
+}
+
+/* allocate a database without tables, derives the tiles of every pattern
+   from the partition and returns NULL if the partition is invalid */
+static snps_pdb_t *snps_pdb_new(unsigned rows, unsigned columns,
+    const unsigned char *goal, const unsigned char *partition)
+{
+    unsigned size = rows * columns;
+    unsigned lengths[size];
+    unsigned count = 0;
+
+    memset(lengths, 0, sizeof(lengths));
+
+    for (int i = 1; i < size; ++i) {
+        if (partition[i] >= size)
+            return NULL;
+        if (partition[i] >= count)
+            count = partition[i] + 1;
+        ++lengths[partition[i]];
+    }
+
+    for (int i = 0; i < count; ++i)
+        if (lengths[i] == 0 || lengths[i] > SNPS_PDB_MAX_TILES)
+            return NULL;
+
+    snps_pdb_t *pdb = g_slice_new(snps_pdb_t);
+    pdb->rows = rows;
+    pdb->columns = columns;
+    pdb->size = size;
+    pdb->count = count;
+    pdb->goal = g_memdup2(goal, size);
+    pdb->partition = g_memdup2(partition, size);
+    pdb->partition[0] = SNPS_PDB_NONE;
+    pdb->tiles = g_new(unsigned char, size - 1);
+    pdb->lengths = g_new0(unsigned, count);
+    pdb->offsets = g_new(unsigned, count);
+    pdb->tables = g_new0(unsigned char *, count);
+    pdb->map = NULL;
+    pdb->map_length = 0;
+
+    for (int i = 0, offset = 0; i < count; offset += lengths[i++])
+        pdb->offsets[i] = offset;
+
+    for (int i = 1; i < size; ++i) {
+        unsigned pattern = partition[i];
+        pdb->tiles[pdb->offsets[pattern] + pdb->lengths[pattern]++] = i;
+    }
+
+    return pdb;
+}
+
+/* number of entries of a pattern table, one per placement of its tiles */
+static guint64 snps_pdb_entries(snps_pdb_t *pdb, unsigned pattern)
+{
+    guint64 entries = 1;
+    for (int i = 0; i < pdb->lengths[pattern]; ++i)
+        entries *= pdb->size - i;
+
+    return entries;
+}
+
+/* file offset of the first table */
+static gsize snps_pdb_tables_offset(snps_pdb_t *pdb)
+{
+    return (sizeof(snps_pdb_header_t) + 2 * pdb->size + 7) & ~(gsize) 7;
+}
+
+/* a retrograde breadth first search starting at the goal, which only counts
+   the moves of the tiles of the pattern and records the distance of the
+   closest state for every placement of these tiles */
+static unsigned char *snps_pdb_build_pattern(snps_pdb_t *pdb,
+    snps_game_t *game, unsigned pattern)
+{
+    unsigned size = pdb->size;
+    unsigned count = pdb->lengths[pattern];
+    const unsigned char *tiles = pdb->tiles + pdb->offsets[pattern];
+    guint64 entries = snps_pdb_entries(pdb, pattern);
+    guint64 states = entries * size;
+
+    /* a state is a placement of the tiles combined with the position of
+       the blank, it is seen once its final distance is known and pending
+       while waiting in the next level */
+    unsigned char *table = g_malloc(entries);
+    guint64 *seen = g_malloc0((states + 63) / 64 * sizeof(guint64));
+    guint64 *pending = g_malloc0((states + 63) / 64 * sizeof(guint64));
+    GArray *level = g_array_new(FALSE, FALSE, sizeof(guint64));
+    GArray *next_level = g_array_new(FALSE, FALSE, sizeof(guint64));
+
+    memset(table, SNPS_PDB_NONE, entries);
+
+    unsigned char positions[size];
+    unsigned char owners[size];
+    unsigned blank = 0;
+
+    for (int i = 0; i < size; ++i) {
+        if (game->to[i] == 0)
+            blank = i;
+        for (int j = 0; j < count; ++j)
+            if (game->to[i] == tiles[j])
+                positions[j] = i;
+    }
+
+    guint64 start = snps_rank(size, count, positions) * size + blank;
+    seen[start / 64] |= G_GUINT64_CONSTANT(1) << (start % 64);
+    g_array_append_val(level, start);
+
+    for (unsigned distance = 0; level->len > 0; ++distance) {
+        for (guint i = 0; i < level->len; ++i) {
+            guint64 state = g_array_index(level, guint64, i);
+            guint64 bit = G_GUINT64_CONSTANT(1) << (state % 64);
+
+            if (pending[state / 64] & bit) {
+                pending[state / 64] &= ~bit;
+                if (seen[state / 64] & bit)
+                    continue;
+                seen[state / 64] |= bit;
+            }
+
+            guint64 rank = state / size;
+            blank = state % size;
+
+            if (table[rank] == SNPS_PDB_NONE)
+                table[rank] = MIN(distance, SNPS_PDB_NONE - 1);
+
+            snps_unrank(size, count, rank, positions);
+            memset(owners, SNPS_PDB_NONE, size);
+            for (int j = 0; j < count; ++j)
+                owners[positions[j]] = j;
+
+            int row = TRANSLATE_1D_TO_ROW(blank, pdb->columns);
+            int column = TRANSLATE_1D_TO_COLUMN(blank, pdb->columns);
+            int neighbours[4] = {
+                column > 0 ? blank - 1 : -1,
+                column < pdb->columns - 1 ? blank + 1 : -1,
+                row > 0 ? blank - pdb->columns : -1,
+                row < pdb->rows - 1 ? blank + pdb->columns : -1,
+            };
+
+            for (int j = 0; j < 4; ++j) {
+                int q = neighbours[j];
+                if (q < 0)
+                    continue;
+
+                /* moving a foreign tile is free and stays on this level,
+                   moving a tile of the pattern costs one move */
+                if (owners[q] == SNPS_PDB_NONE) {
+                    guint64 child = rank * size + q;
+                    guint64 child_bit = G_GUINT64_CONSTANT(1) << (child % 64);
+                    if (seen[child / 64] & child_bit)
+                        continue;
+                    seen[child / 64] |= child_bit;
+                    g_array_append_val(level, child);
+                } else {
+                    positions[owners[q]] = blank;
+                    guint64 child = snps_rank(size, count, positions) *
+                        size + q;
+                    guint64 child_bit = G_GUINT64_CONSTANT(1) << (child % 64);
+                    positions[owners[q]] = q;
+                    if ((seen[child / 64] | pending[child / 64]) & child_bit)
+                        continue;
+                    pending[child / 64] |= child_bit;
+                    g_array_append_val(next_level, child);
+                }
+            }
+        }
+
+        GArray *tmp = level;
+        level = next_level;
+        next_level = g_array_set_size(tmp, 0);
+    }
+
+    /* placements not reachable from the goal can't occur in solvable
+       games, zero keeps the estimate admissible anyway */
+    for (guint64 i = 0; i < entries; ++i)
+        if (table[i] == SNPS_PDB_NONE)
+            table[i] = 0;
+
+    g_array_free(next_level, TRUE);
+    g_array_free(level, TRUE);
+    g_free(pending);
+    g_free(seen);
+
+    return table;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,242 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+/* data type, boards of a perimeter refer to the next board on a shortest
+   route to the goal board */
+typedef struct {
+    guint32 next;
+    unsigned char distance;
+    unsigned char blank;
+    guint64 key[];
+} snps_border_t;
+
+/* prototypes */
+static snps_perimeter_t *snps_perimeter_find(snps_game_t *game,
+    unsigned depth);
+static snps_perimeter_t *snps_perimeter_build(snps_game_t *game,
+    unsigned depth);
+static void snps_perimeter_free(snps_perimeter_t *perimeter);
+static snps_border_t *snps_perimeter_border(snps_perimeter_t *perimeter,
+    guint32 index);
+
+/* perimeters shared by all games with the same goal board and depth */
+static GMutex snps_perimeters_lock;
+static GList *snps_perimeters = NULL;
+
+extern void snps_game_set_perimeter(snps_game_t *game, unsigned depth)
+{
+    if (game->perimeter != NULL)
+        snps_perimeter_release(game->perimeter);
+    game->perimeter = NULL;
+
+    /* the goal board of an unsolvable game may lack the blank */
+    if (depth > 0 && snps_game_solvable(game))
+        game->perimeter = snps_perimeter_acquire(game, MIN(depth, 255));
+}
+
+extern snps_perimeter_t *snps_perimeter_acquire(snps_game_t *game,
+    unsigned depth)
+{
+    g_mutex_lock(&snps_perimeters_lock);
+
+    snps_perimeter_t *perimeter = snps_perimeter_find(game, depth);
+
+    /* it's built without the lock so games with other goal boards don't
+       wait for it, the first one finished is kept if games with the same
+       goal board build it at once */
+    if (perimeter == NULL) {
+        g_mutex_unlock(&snps_perimeters_lock);
+        snps_perimeter_t *built = snps_perimeter_build(game, depth);
+        g_mutex_lock(&snps_perimeters_lock);
+
+        perimeter = snps_perimeter_find(game, depth);
+        if (perimeter == NULL) {
+            perimeter = built;
+            snps_perimeters = g_list_prepend(snps_perimeters, perimeter);
+        } else {
+            snps_perimeter_free(built);
+        }
+    }
+
+    ++perimeter->references;
+
+    g_mutex_unlock(&snps_perimeters_lock);
+
+    return perimeter;
+}
+
+extern void snps_perimeter_release(snps_perimeter_t *perimeter)
+{
+    g_mutex_lock(&snps_perimeters_lock);
+
+    if (--perimeter->references == 0) {
+        snps_perimeters = g_list_remove(snps_perimeters, perimeter);
+        snps_perimeter_free(perimeter);
+    }
+
+    g_mutex_unlock(&snps_perimeters_lock);
+}
+
+extern unsigned snps_perimeter_distance(snps_perimeter_t *perimeter,
+    const guint64 *key)
+{
+    guint32 index = snps_set_find(perimeter->set, key);
+
+    if (index == SNPS_NONE)
+        return G_MAXUINT;
+
+    return snps_perimeter_border(perimeter, index)->distance;
+}
+
+extern unsigned snps_perimeter_moves(snps_game_t *game,
+    const guint64 *key, char *moves)
+{
+    snps_perimeter_t *perimeter = game->perimeter;
+    guint32 index = snps_set_find(perimeter->set, key);
+    unsigned count = 0;
+
+    if (index == SNPS_NONE)
+        return 0;
+
+    while (42) {
+        snps_border_t *border = snps_perimeter_border(perimeter, index);
+
+        if (border->next == SNPS_NONE)
+            break;
+
+        unsigned q = snps_perimeter_border(perimeter, border->next)->blank;
+
+        moves[count++] = snps_route_direction(game, border->blank, q);
+
+        index = border->next;
+    }
+
+    return count;
+}
+
+/* the shared perimeter of the goal board of a game, NULL if there's none
+   yet, the lock of the perimeters has to be held */
+static snps_perimeter_t *snps_perimeter_find(snps_game_t *game,
+    unsigned depth)
+{
+    for (GList *item = snps_perimeters; item != NULL; item = item->next) {
+        snps_perimeter_t *other = (snps_perimeter_t *) item->data;
+
+        if (other->rows == game->rows && other->columns == game->columns &&
+            other->depth == depth &&
+            memcmp(other->goal, game->to, game->size) == 0)
+            return other;
+    }
+
+    return NULL;
+}
+
+/* a breadth first search from the goal board up to the depth, the boards
+   are allocated level by level, so every board in the pool is expanded
+   right after those before it */
+static snps_perimeter_t *snps_perimeter_build(snps_game_t *game,
+    unsigned depth)
+{
+    snps_perimeter_t *perimeter = g_slice_new0(snps_perimeter_t);
+    perimeter->rows = game->rows;
+    perimeter->columns = game->columns;
+    perimeter->depth = depth;
+    perimeter->goal = g_slice_copy(game->size, game->to);
+    snps_packing_init(&perimeter->packing, game->size);
+
+    unsigned words = perimeter->packing.words;
+    perimeter->pool = snps_pool_new();
+    snps_pool_reset(perimeter->pool, sizeof(snps_border_t) +
+        words * sizeof(guint64));
+    perimeter->set = snps_set_new(perimeter->pool,
+        G_STRUCT_OFFSET(snps_border_t, key));
+    snps_set_reset(perimeter->set, words);
+    perimeter->set->profile = &perimeter->profile;
+
+    guint32 index = snps_pool_alloc(perimeter->pool);
+    snps_border_t *goal = snps_perimeter_border(perimeter, index);
+    goal->next = SNPS_NONE;
+    goal->distance = 0;
+    goal->blank = 0;
+    while (game->to[goal->blank] != 0)
+        ++goal->blank;
+    snps_key_pack(&perimeter->packing, goal->key, game->to);
+    snps_set_fill(perimeter->set, snps_set_slot(perimeter->set, goal->key),
+        goal->key, index);
+
+    for (guint32 i = 0; i < perimeter->pool->count; ++i) {
+        snps_border_t *border = snps_perimeter_border(perimeter, i);
+
+        if (border->distance == depth)
+            break;
+
+        int cells[4];
+        snps_neighbours(game, border->blank, cells);
+
+        for (int j = 0; j < 4; ++j) {
+            if (cells[j] < 0)
+                continue;
+
+            guint64 key[words];
+            memcpy(key, border->key, words * sizeof(guint64));
+            snps_key_move(&perimeter->packing, key, border->blank, cells[j]);
+
+            snps_slot_t *slot = snps_set_slot(perimeter->set, key);
+            if (snps_set_item(perimeter->set, slot) != SNPS_NONE)
+                continue;
+
+            index = snps_pool_alloc(perimeter->pool);
+            snps_border_t *child = snps_perimeter_border(perimeter, index);
+            child->next = i;
+            child->distance = border->distance + 1;
+            child->blank = cells[j];
+            memcpy(child->key, key, words * sizeof(guint64));
+            snps_set_fill(perimeter->set, slot, key, index);
+        }
+    }
+
+    return perimeter;
+}
+
+static void snps_perimeter_free(snps_perimeter_t *perimeter)
+{
+    snps_set_free(perimeter->set);
+    snps_pool_free(perimeter->pool);
+    g_slice_free1(perimeter->rows * perimeter->columns, perimeter->goal);
+    g_slice_free(snps_perimeter_t, perimeter);
+}
+
+static snps_border_t *snps_perimeter_border(snps_perimeter_t *perimeter,
+    guint32 index)
+{
+    return (snps_border_t *) snps_pool_get(perimeter->pool, index);
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,83 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <glib.h>
+
+#define SNPS_POOL_CHUNK_ITEMS (1u << SNPS_POOL_CHUNK_BITS)
+
+extern snps_pool_t *snps_pool_new(void)
+{
+    snps_pool_t *pool = g_slice_new(snps_pool_t);
+    pool->chunks = NULL;
+    pool->chunk_count = 0;
+    pool->chunk_item_size = 0;
+    pool->item_size = 0;
+    pool->count = 0;
+
+    return pool;
+}
+
+extern void snps_pool_free(snps_pool_t *pool)
+{
+    for (int i = 0; i < pool->chunk_count; ++i)
+        g_free(pool->chunks[i]);
+
+    g_free(pool->chunks);
+    g_slice_free(snps_pool_t, pool);
+}
+
+extern void snps_pool_reset(snps_pool_t *pool, gsize item_size)
+{
+    if (item_size > pool->chunk_item_size) {
+        for (int i = 0; i < pool->chunk_count; ++i)
+            g_free(pool->chunks[i]);
+        pool->chunk_count = 0;
+        pool->chunk_item_size = item_size;
+    }
+
+    pool->item_size = item_size;
+    pool->count = 0;
+}
+
+extern guint32 snps_pool_alloc(snps_pool_t *pool)
+{
+    guint32 index = pool->count;
+
+    if (index == SNPS_NONE)
+        g_error("snps: more states than 32 bit indexes can address");
+
+    if ((index >> SNPS_POOL_CHUNK_BITS) == pool->chunk_count) {
+        pool->chunks = g_renew(char *, pool->chunks, pool->chunk_count + 1);
+        pool->chunks[pool->chunk_count++] = g_malloc(SNPS_POOL_CHUNK_ITEMS *
+            pool->chunk_item_size);
+    }
+
+    ++pool->count;
+
+    return index;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
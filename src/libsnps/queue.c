@@ -0,0 +1,165 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "snps_private.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#define SNPS_QUEUE_INITIAL_SIZE 64
+#define SNPS_BUCKET_INITIAL_SIZE 16
+
+/* prototypes */
+static void *snps_queue_grow(void *array, unsigned *capacity,
+    unsigned needed, gsize size);
+
+extern snps_queue_t *snps_queue_new(void)
+{
+    snps_queue_t *queue = g_slice_new(snps_queue_t);
+    queue->levels = NULL;
+    queue->capacity = 0;
+    queue->count = 0;
+    queue->min = G_MAXUINT;
+    queue->generation = 1;
+    queue->profile = NULL;
+
+    return queue;
+}
+
+extern void snps_queue_free(snps_queue_t *queue)
+{
+    for (int i = 0; i < queue->capacity; ++i) {
+        for (int j = 0; j < queue->levels[i].capacity; ++j)
+            g_free(queue->levels[i].buckets[j].items);
+        g_free(queue->levels[i].buckets);
+    }
+
+    g_free(queue->levels);
+    g_slice_free(snps_queue_t, queue);
+}
+
+extern void snps_queue_reset(snps_queue_t *queue)
+{
+    queue->count = 0;
+    queue->min = G_MAXUINT;
+
+    /* the levels are only cleared once the generations wrap around */
+    if (++queue->generation == 0) {
+        for (int i = 0; i < queue->capacity; ++i)
+            queue->levels[i].generation = 0;
+        queue->generation = 1;
+    }
+}
+
+extern void snps_queue_push(snps_queue_t *queue, unsigned f, unsigned h,
+    guint32 item)
+{
+    if (f >= queue->capacity)
+        queue->levels = snps_queue_grow(queue->levels, &queue->capacity, f,
+            sizeof(snps_level_t));
+
+    snps_level_t *level = queue->levels + f;
+
+    /* drop what was left behind by a previous search */
+    if (level->generation != queue->generation) {
+        for (int i = 0; i < level->capacity; ++i)
+            level->buckets[i].length = 0;
+        level->count = 0;
+        level->generation = queue->generation;
+    }
+    if (h >= level->capacity)
+        level->buckets = snps_queue_grow(level->buckets, &level->capacity, h,
+            sizeof(snps_bucket_t));
+
+    snps_bucket_t *bucket = level->buckets + h;
+    if (bucket->length == bucket->capacity) {
+        bucket->capacity = bucket->capacity == 0 ? SNPS_BUCKET_INITIAL_SIZE
+            : 2 * bucket->capacity;
+        bucket->items = g_renew(guint32, bucket->items, bucket->capacity);
+    }
+
+    bucket->items[bucket->length++] = item;
+
+    if (level->count++ == 0 || h < level->min)
+        level->min = h;
+    if (queue->count++ == 0 || f < queue->min)
+        queue->min = f;
+
+    SNPS_PROFILE_ADD(queue->profile, pushes, 1);
+    SNPS_PROFILE_PEAK(queue->profile, open_peak, queue->count);
+}
+
+extern guint32 snps_queue_peek(snps_queue_t *queue)
+{
+    if (queue->count == 0)
+        return SNPS_NONE;
+
+    while (queue->levels[queue->min].count == 0 ||
+        queue->levels[queue->min].generation != queue->generation)
+        ++queue->min;
+
+    snps_level_t *level = queue->levels + queue->min;
+    while (level->buckets[level->min].length == 0)
+        ++level->min;
+
+    snps_bucket_t *bucket = level->buckets + level->min;
+    return bucket->items[bucket->length - 1];
+}
+
+extern guint32 snps_queue_pop(snps_queue_t *queue)
+{
+    if (snps_queue_peek(queue) == SNPS_NONE)
+        return SNPS_NONE;
+
+    snps_level_t *level = queue->levels + queue->min;
+
+    --level->count;
+    --queue->count;
+
+    SNPS_PROFILE_ADD(queue->profile, pops, 1);
+
+    snps_bucket_t *bucket = level->buckets + level->min;
+    return bucket->items[--bucket->length];
+}
+
+/* enlarge a zero initialised array to hold at least needed + 1 elements */
+static void *snps_queue_grow(void *array, unsigned *capacity,
+    unsigned needed, gsize size)
+{
+    unsigned old = *capacity;
+    unsigned capacity_new = old == 0 ? SNPS_QUEUE_INITIAL_SIZE : old;
+
+    while (capacity_new <= needed)
+        capacity_new *= 2;
+
+    array = g_realloc(array, capacity_new * size);
+    memset((char *) array + old * size, 0, (capacity_new - old) * size);
+    *capacity = capacity_new;
+
+    return array;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
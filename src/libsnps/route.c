@@ -0,0 +1,203 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+/* the moves of the blank in the order of their two bit codes */
+static const char snps_directions[] = "LRUD";
+
+/* prototypes */
+static unsigned snps_route_blank(const unsigned char *board, unsigned size);
+static unsigned snps_route_target(const snps_route_t *route, unsigned blank,
+    unsigned index);
+
+extern void snps_game_set_route_format(snps_game_t *game, unsigned format)
+{
+    game->route_format = format;
+}
+
+extern snps_route_t *snps_route_alloc(snps_game_t *game,
+    const unsigned char *start, unsigned count)
+{
+    snps_route_t *route = g_slice_new(snps_route_t);
+    route->boards = NULL;
+    route->moves = NULL;
+    route->size = game->size;
+    route->length = count + 1;
+    route->optimal = 0;
+    route->columns = game->columns;
+    route->start = g_slice_copy(game->size, start);
+    route->packed = g_slice_alloc0(count / 4 + 1);
+
+    return route;
+}
+
+extern void snps_route_set_move(snps_route_t *route, unsigned index,
+    char move)
+{
+    unsigned code = strchr(snps_directions, move) - snps_directions;
+    route->packed[index / 4] |= code << (index % 4 * 2);
+}
+
+extern void snps_route_complete(snps_game_t *game, snps_route_t *route)
+{
+    if (game->route_format & SNPS_ROUTE_MOVES) {
+        route->moves = g_slice_alloc(route->length);
+        snps_route_write_moves(route, (char *) route->moves);
+    }
+
+    if (game->route_format & SNPS_ROUTE_BOARDS) {
+        route->boards = g_slice_alloc(route->length * sizeof(char *));
+        route->boards[0] = g_slice_copy(route->size, route->start);
+
+        unsigned p = snps_route_blank(route->start, route->size);
+        for (unsigned i = 1; i < route->length; ++i) {
+            unsigned q = snps_route_target(route, p, i - 1);
+            route->boards[i] = g_slice_copy(route->size, route->boards[i - 1]);
+            route->boards[i][p] = route->boards[i][q];
+            route->boards[i][q] = 0;
+            p = q;
+        }
+    }
+}
+
+extern snps_route_t *snps_route_new_moves(snps_game_t *game,
+    const char *moves, unsigned count)
+{
+    snps_route_t *route = snps_route_alloc(game, game->from, count);
+    for (unsigned i = 0; i < count; ++i)
+        snps_route_set_move(route, i, moves[i]);
+    snps_route_complete(game, route);
+
+    return route;
+}
+
+extern char snps_route_direction(snps_game_t *game, unsigned from,
+    unsigned to)
+{
+    int from_p_row = TRANSLATE_1D_TO_ROW(from, game->columns);
+    int from_p_column = TRANSLATE_1D_TO_COLUMN(from, game->columns);
+    int to_p_row = TRANSLATE_1D_TO_ROW(to, game->columns);
+    int to_p_column = TRANSLATE_1D_TO_COLUMN(to, game->columns);
+
+    if (from_p_row > to_p_row)
+        return 'U';
+    else if (from_p_row < to_p_row)
+        return 'D';
+    else if (from_p_column > to_p_column)
+        return 'L';
+    else
+        return 'R';
+}
+
+extern void snps_route_free(snps_route_t *route)
+{
+    if (route->boards != NULL) {
+        for (int i = 0; i < route->length; ++i)
+            g_slice_free1(route->size, route->boards[i]);
+        g_slice_free1(route->length * sizeof(char *), route->boards);
+    }
+
+    if (route->moves != NULL)
+        g_slice_free1(route->length, route->moves);
+
+    g_slice_free1(route->size, route->start);
+    g_slice_free1((route->length - 1) / 4 + 1, route->packed);
+    g_slice_free(snps_route_t, route);
+}
+
+extern char snps_route_move(const snps_route_t *route, unsigned index)
+{
+    return snps_directions[route->packed[index / 4] >> (index % 4 * 2) & 3];
+}
+
+extern void snps_route_write_moves(const snps_route_t *route, char *moves)
+{
+    for (unsigned i = 0; i + 1 < route->length; ++i)
+        moves[i] = snps_route_move(route, i);
+    moves[route->length - 1] = '\0';
+}
+
+extern void snps_route_board(const snps_route_t *route, unsigned index,
+    unsigned char *board)
+{
+    snps_route_iter_t iter;
+
+    snps_route_iter_init(&iter, route, board);
+    while (iter.index < index && snps_route_iter_next(&iter))
+        ;
+}
+
+extern void snps_route_iter_init(snps_route_iter_t *iter,
+    const snps_route_t *route, unsigned char *board)
+{
+    memcpy(board, route->start, route->size);
+    iter->route = route;
+    iter->board = board;
+    iter->index = 0;
+    iter->blank = snps_route_blank(board, route->size);
+}
+
+extern int snps_route_iter_next(snps_route_iter_t *iter)
+{
+    if (iter->index + 1 >= iter->route->length)
+        return 0;
+
+    unsigned p = iter->blank;
+    unsigned q = snps_route_target(iter->route, p, iter->index);
+    iter->board[p] = iter->board[q];
+    iter->board[q] = 0;
+    iter->blank = q;
+    ++iter->index;
+
+    return 1;
+}
+
+/* the cell of the blank on a board */
+static unsigned snps_route_blank(const unsigned char *board, unsigned size)
+{
+    unsigned p = 0;
+    while (p < size && board[p] != 0)
+        ++p;
+
+    return p;
+}
+
+/* the cell the blank moves to from its cell with a move of a route */
+static unsigned snps_route_target(const snps_route_t *route, unsigned blank,
+    unsigned index)
+{
+    switch (snps_route_move(route, index)) {
+        case 'L': return blank - 1;
+        case 'R': return blank + 1;
+        case 'U': return blank - route->columns;
+        default: return blank + route->columns;
+    }
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
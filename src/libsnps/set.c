@@ -0,0 +1,192 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "snps_private.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#define SNPS_SET_INITIAL_SIZE 1024
+
+/* prototypes */
+static void snps_set_grow(snps_set_t *set);
+
+extern void snps_packing_init(snps_packing_t *packing, unsigned size)
+{
+    packing->size = size;
+    packing->bits = 4;
+
+    while ((1u << packing->bits) < size)
+        ++packing->bits;
+
+    packing->tiles = 64 / packing->bits;
+    packing->words = (size + packing->tiles - 1) / packing->tiles;
+}
+
+extern void snps_key_pack(const snps_packing_t *packing, guint64 *key,
+    const unsigned char *board)
+{
+    if (packing->words == 1) {
+        unsigned char padded[16] = {0};
+        memcpy(padded, board, packing->size);
+        key[0] = snps_simd_ops->pack(padded);
+        return;
+    }
+
+    memset(key, 0, packing->words * sizeof(guint64));
+
+    for (int i = 0; i < packing->size; ++i)
+        key[i / packing->tiles] |= (guint64) board[i] <<
+            (i % packing->tiles * packing->bits);
+}
+
+extern void snps_key_unpack(const snps_packing_t *packing,
+    const guint64 *key, unsigned char *board)
+{
+    if (packing->words == 1) {
+        unsigned char padded[16];
+        snps_simd_ops->unpack(key[0], padded);
+        memcpy(board, padded, packing->size);
+        return;
+    }
+
+    for (int i = 0; i < packing->size; ++i)
+        board[i] = snps_key_get(packing, key, i);
+}
+
+extern snps_set_t *snps_set_new(snps_pool_t *pool, gsize offset)
+{
+    snps_set_t *set = g_slice_new(snps_set_t);
+    set->slots = g_new0(snps_slot_t, SNPS_SET_INITIAL_SIZE);
+    set->mask = SNPS_SET_INITIAL_SIZE - 1;
+    set->count = 0;
+    set->words = 1;
+    set->pool = pool;
+    set->offset = offset;
+    set->generation = 1;
+    set->profile = NULL;
+
+    return set;
+}
+
+extern void snps_set_free(snps_set_t *set)
+{
+    g_free(set->slots);
+    g_slice_free(snps_set_t, set);
+}
+
+extern void snps_set_reset(snps_set_t *set, unsigned words)
+{
+    set->count = 0;
+    set->words = words;
+
+    /* the slots are only cleared once the generations wrap around */
+    if (++set->generation == 0) {
+        memset(set->slots, 0, (set->mask + 1) * sizeof(snps_slot_t));
+        set->generation = 1;
+    }
+}
+
+extern snps_slot_t *snps_set_slot(snps_set_t *set, const guint64 *key)
+{
+    /* grow early, so the returned slot stays valid until it's filled */
+    if (2 * (set->count + 1) > set->mask + 1)
+        snps_set_grow(set);
+
+    guint64 hash = snps_key_hash(key, set->words);
+    guint64 tag = set->words == 1 ? key[0] : hash;
+
+    for (gsize i = hash & set->mask; ; i = (i + 1) & set->mask) {
+        snps_slot_t *slot = set->slots + i;
+
+        SNPS_PROFILE_ADD(set->profile, probes, 1);
+
+        if (slot->generation != set->generation)
+            return slot;
+
+        if (slot->tag == tag && (set->words == 1 || memcmp(key,
+            (char *) snps_pool_get(set->pool, slot->item) + set->offset,
+            set->words * sizeof(guint64)) == 0))
+            return slot;
+
+        SNPS_PROFILE_ADD(set->profile, collisions, 1);
+    }
+}
+
+extern void snps_set_fill(snps_set_t *set, snps_slot_t *slot,
+    const guint64 *key, guint32 item)
+{
+    slot->tag = set->words == 1 ? key[0] : snps_key_hash(key, set->words);
+    slot->item = item;
+    slot->generation = set->generation;
+    ++set->count;
+}
+
+extern guint32 snps_set_find(snps_set_t *set, const guint64 *key)
+{
+    guint64 hash = snps_key_hash(key, set->words);
+    guint64 tag = set->words == 1 ? key[0] : hash;
+
+    for (gsize i = hash & set->mask; ; i = (i + 1) & set->mask) {
+        snps_slot_t *slot = set->slots + i;
+
+        if (slot->generation != set->generation)
+            return SNPS_NONE;
+
+        if (slot->tag == tag && (set->words == 1 || memcmp(key,
+            (char *) snps_pool_get(set->pool, slot->item) + set->offset,
+            set->words * sizeof(guint64)) == 0))
+            return slot->item;
+    }
+}
+
+/* double the number of slots and reinsert all items */
+static void snps_set_grow(snps_set_t *set)
+{
+    snps_slot_t *slots = set->slots;
+    gsize capacity = set->mask + 1;
+
+    set->mask = 2 * capacity - 1;
+    set->slots = g_new0(snps_slot_t, 2 * capacity);
+
+    for (gsize i = 0; i < capacity; ++i) {
+        if (slots[i].generation != set->generation)
+            continue;
+
+        guint64 hash = set->words == 1 ?
+            snps_key_hash(&slots[i].tag, 1) : slots[i].tag;
+        gsize j = hash & set->mask;
+
+        while (set->slots[j].generation == set->generation)
+            j = (j + 1) & set->mask;
+
+        set->slots[j] = slots[i];
+    }
+
+    g_free(slots);
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,251 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+/* the vector versions are built with the instructions enabled per function
+   and only called once the processor is known to support them */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SNPS_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/* prototypes */
+static void snps_simd_use(snps_simd_t simd);
+static void snps_unpack_scalar(guint64 key, unsigned char *board);
+static guint64 snps_pack_scalar(const unsigned char *board);
+static unsigned snps_manhattan_scalar(const snps_game_t *game,
+    const unsigned char *board);
+#ifdef SNPS_SIMD_X86
+static void snps_unpack_sse4(guint64 key, unsigned char *board);
+static guint64 snps_pack_sse4(const unsigned char *board);
+static unsigned snps_manhattan_sse4(const snps_game_t *game,
+    const unsigned char *board);
+static unsigned snps_manhattan_avx2(const snps_game_t *game,
+    const unsigned char *board);
+#endif
+
+static const snps_simd_ops_t snps_simd_scalar = {
+    snps_unpack_scalar,
+    snps_pack_scalar,
+    snps_manhattan_scalar,
+};
+
+#ifdef SNPS_SIMD_X86
+static const snps_simd_ops_t snps_simd_sse4 = {
+    snps_unpack_sse4,
+    snps_pack_sse4,
+    snps_manhattan_sse4,
+};
+
+static const snps_simd_ops_t snps_simd_avx2 = {
+    snps_unpack_sse4,
+    snps_pack_sse4,
+    snps_manhattan_avx2,
+};
+#endif
+
+const snps_simd_ops_t *snps_simd_ops = &snps_simd_scalar;
+
+/* the best instructions of the processor and those used right now */
+static snps_simd_t snps_simd_detected = SNPS_SIMD_SCALAR;
+static snps_simd_t snps_simd_used = SNPS_SIMD_SCALAR;
+
+extern void snps_simd_init(void)
+{
+    static gsize initialized = 0;
+
+    if (!g_once_init_enter(&initialized))
+        return;
+
+#ifdef SNPS_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        snps_simd_detected = SNPS_SIMD_AVX2;
+    else if (__builtin_cpu_supports("sse4.1"))
+        snps_simd_detected = SNPS_SIMD_SSE4;
+#endif
+
+    snps_simd_use(snps_simd_detected);
+    g_once_init_leave(&initialized, 1);
+}
+
+extern snps_simd_t snps_simd_level(void)
+{
+    snps_simd_init();
+
+    return snps_simd_used;
+}
+
+extern snps_simd_t snps_simd_limit(snps_simd_t simd)
+{
+    snps_simd_init();
+    snps_simd_use(MIN(simd, snps_simd_detected));
+
+    return snps_simd_used;
+}
+
+/* switch the board operations over to the given instructions */
+static void snps_simd_use(snps_simd_t simd)
+{
+    snps_simd_used = simd;
+
+    switch (simd) {
+#ifdef SNPS_SIMD_X86
+        case SNPS_SIMD_AVX2: snps_simd_ops = &snps_simd_avx2; break;
+        case SNPS_SIMD_SSE4: snps_simd_ops = &snps_simd_sse4; break;
+#endif
+        default: snps_simd_ops = &snps_simd_scalar; break;
+    }
+}
+
+/* one tile per nibble */
+static void snps_unpack_scalar(guint64 key, unsigned char *board)
+{
+    for (int i = 0; i < 16; ++i)
+        board[i] = (key >> (i * 4)) & 0xf;
+}
+
+static guint64 snps_pack_scalar(const unsigned char *board)
+{
+    guint64 key = 0;
+
+    for (int i = 0; i < 16; ++i)
+        key |= (guint64) board[i] << (i * 4);
+
+    return key;
+}
+
+static unsigned snps_manhattan_scalar(const snps_game_t *game,
+    const unsigned char *board)
+{
+    unsigned h = 0;
+
+    for (int i = 0; i < game->size; ++i)
+        h += game->distances[board[i] * game->size + i];
+
+    return h;
+}
+
+#ifdef SNPS_SIMD_X86
+/* the low nibbles of the key are the tiles of the even cells */
+__attribute__((target("sse4.1")))
+static void snps_unpack_sse4(guint64 key, unsigned char *board)
+{
+    __m128i mask = _mm_set1_epi8(0xf);
+    __m128i packed = _mm_cvtsi64_si128(key);
+    __m128i even = _mm_and_si128(packed, mask);
+    __m128i odd = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+
+    _mm_storeu_si128((__m128i *) board, _mm_unpacklo_epi8(even, odd));
+}
+
+/* every pair of cells becomes one byte by multiplying the odd cell by 16 */
+__attribute__((target("sse4.1")))
+static guint64 snps_pack_sse4(const unsigned char *board)
+{
+    __m128i tiles = _mm_loadu_si128((const __m128i *) board);
+    __m128i pairs = _mm_maddubs_epi16(tiles, _mm_set1_epi16(0x1001));
+
+    return _mm_cvtsi128_si64(_mm_packus_epi16(pairs, pairs));
+}
+
+/* look up the goal cells of all tiles at once, the distance of the blank
+   and of the cells beyond the board is masked */
+__attribute__((target("sse4.1")))
+static unsigned snps_manhattan_sse4(const snps_game_t *game,
+    const unsigned char *board)
+{
+    if (game->size > 16)
+        return snps_manhattan_scalar(game, board);
+
+    unsigned char padded[16] = {0};
+    memcpy(padded, board, game->size);
+
+    __m128i tiles = _mm_loadu_si128((const __m128i *) padded);
+    __m128i goal_rows = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i *) game->goal_rows), tiles);
+    __m128i goal_columns = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i *) game->goal_columns), tiles);
+    __m128i rows = _mm_loadu_si128((const __m128i *) game->cell_rows);
+    __m128i columns = _mm_loadu_si128((const __m128i *) game->cell_columns);
+
+    __m128i distances = _mm_add_epi8(
+        _mm_abs_epi8(_mm_sub_epi8(goal_rows, rows)),
+        _mm_abs_epi8(_mm_sub_epi8(goal_columns, columns)));
+    distances = _mm_andnot_si128(
+        _mm_cmpeq_epi8(tiles, _mm_setzero_si128()), distances);
+
+    __m128i sums = _mm_sad_epu8(distances, _mm_setzero_si128());
+
+    return _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+}
+
+/* boards of up to 32 cells, the goal cells of tiles above 15 are looked up
+   in the upper half of the tables and blended in */
+__attribute__((target("avx2")))
+static unsigned snps_manhattan_avx2(const snps_game_t *game,
+    const unsigned char *board)
+{
+    if (game->size > 32)
+        return snps_manhattan_scalar(game, board);
+
+    unsigned char padded[32] = {0};
+    memcpy(padded, board, game->size);
+
+    __m256i tiles = _mm256_loadu_si256((const __m256i *) padded);
+    __m256i upper = _mm256_cmpgt_epi8(tiles, _mm256_set1_epi8(15));
+    __m256i goal_rows = _mm256_blendv_epi8(
+        _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128(
+            (const __m128i *) game->goal_rows)), tiles),
+        _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128(
+            (const __m128i *) (game->goal_rows + 16))), tiles), upper);
+    __m256i goal_columns = _mm256_blendv_epi8(
+        _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128(
+            (const __m128i *) game->goal_columns)), tiles),
+        _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128(
+            (const __m128i *) (game->goal_columns + 16))), tiles), upper);
+    __m256i rows = _mm256_loadu_si256((const __m256i *) game->cell_rows);
+    __m256i columns = _mm256_loadu_si256(
+        (const __m256i *) game->cell_columns);
+
+    __m256i distances = _mm256_add_epi8(
+        _mm256_abs_epi8(_mm256_sub_epi8(goal_rows, rows)),
+        _mm256_abs_epi8(_mm256_sub_epi8(goal_columns, columns)));
+    distances = _mm256_andnot_si256(
+        _mm256_cmpeq_epi8(tiles, _mm256_setzero_si256()), distances);
+
+    __m256i sums = _mm256_sad_epu8(distances, _mm256_setzero_si256());
+    __m128i halves = _mm_add_epi64(_mm256_castsi256_si128(sums),
+        _mm256_extracti128_si256(sums, 1));
+
+    return _mm_cvtsi128_si32(halves) + _mm_extract_epi16(halves, 4);
+}
+#endif
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
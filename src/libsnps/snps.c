@@ -22,197 +22,1047 @@
  * THE SOFTWARE.
  */
 
-#include "snps.h"
+#include "snps_private.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 #include <glib.h>
 
-/* data type */
-typedef struct state {
-    struct state *parent;
-    unsigned char *board;
-    unsigned char size;
-    unsigned g, h, f;
+/* weights of the anytime search in quarters, starting at 3 and lowered by
+   a half after every route */
+#define SNPS_ANYTIME_SCALE 4
+#define SNPS_ANYTIME_WEIGHT 12
+#define SNPS_ANYTIME_STEP 2
+
+/* data type, states live in the pool of a search and refer to their
+   parent by its index */
+typedef struct {
+    guint32 parent;
+    unsigned g, h;
+    unsigned char blank;
+    unsigned char list;
+    guint64 key[];
 } snps_state_t;
 
+/* the list of a state, inconsistent states were reached on a shorter route
+   after they have been expanded and wait for the next anytime iteration */
+enum {
+    SNPS_LIST_OPEN,
+    SNPS_LIST_CLOSED,
+    SNPS_LIST_INCONSISTENT,
+    SNPS_LIST_NONE,
+};
+
+/* how a solver runs */
+typedef struct {
+    unsigned threads;
+    snps_stats_f callback;
+    snps_improved_f improved;
+    void *data;
+    snps_budget_t budget;
+} snps_settings_t;
+
+typedef struct {
+    snps_game_t *game;
+    snps_packing_t packing;
+    snps_pool_t *pool;
+    snps_set_t *state_set;
+    guint64 *goal;
+    snps_profile_t *profile;
+} snps_search_t;
+
+typedef struct {
+    unsigned *counts;
+    unsigned capacity;
+    unsigned min;
+} snps_histogram_t;
+
+/* one side of a bidirectional search, the histograms hold the g and f
+   values of the open states */
+typedef struct {
+    snps_search_t search;
+    snps_queue_t *open;
+    snps_histogram_t g_values;
+    snps_histogram_t f_values;
+} snps_frontier_t;
+
 /* prototypes */
-static snps_state_t *snps_game_start(snps_game_t *game, GHashTable *state_set);
-static int snps_state_children_list(snps_state_t *parent,
-    snps_game_t *game, GHashTable *state_set, GList **list);
-static int snps_state_children_sequence(snps_state_t *parent,
-    snps_game_t *game, GHashTable *state_set, GSequence *todo);
-static void snps_state_children(snps_state_t *parent, snps_game_t *game,
-    GHashTable *state_set, snps_state_t **ret);
-static snps_state_t *snps_state_move(snps_state_t *parent, snps_game_t *game,
-    GHashTable *state_set, unsigned char p1, unsigned char p2);
-static unsigned snps_state_heuristic(snps_state_t *state, snps_game_t *game);
-static guint snps_state_hash(gconstpointer a);
-static gboolean snps_state_equals(gconstpointer a, gconstpointer b);
-static gint snps_state_compare(gconstpointer a, gconstpointer b,
-    gpointer user_data);
-static void snps_state_free(gpointer data);
-static snps_route_t *snps_route_new(snps_state_t *end, snps_game_t *game);
+static snps_route_t *snps_run(snps_solver_t *solver, snps_game_t *game,
+    snps_algorithm_t algorithm, snps_settings_t *settings,
+    snps_stats_t *stats);
+static snps_route_t *snps_run_optimal(snps_solver_t *solver,
+    snps_game_t *game, snps_settings_t *settings, snps_stats_t *stats);
+static snps_route_t *snps_run_fast(snps_solver_t *solver, snps_game_t *game,
+    snps_settings_t *settings, snps_stats_t *stats);
+static snps_route_t *snps_run_bidirectional(snps_solver_t *solver,
+    snps_game_t *game, snps_settings_t *settings, snps_stats_t *stats);
+static snps_route_t *snps_run_best_first(snps_solver_t *solver,
+    snps_game_t *game, unsigned weight, snps_settings_t *settings,
+    snps_stats_t *stats);
+static snps_route_t *snps_run_anytime(snps_solver_t *solver,
+    snps_game_t *game, snps_settings_t *settings, snps_stats_t *stats);
+static int snps_anytime_expand(snps_search_t *search, snps_queue_t *open,
+    guint32 current, unsigned weight, unsigned *cost, guint32 *goal);
+static unsigned snps_anytime_rebuild(snps_search_t *search,
+    snps_queue_t *open, unsigned weight);
+static void snps_search_init(snps_search_t *search, snps_solver_t *solver,
+    int side, snps_game_t *game, snps_profile_t *profile);
+static void snps_search_clear(snps_search_t *search);
+static void snps_search_profile(snps_search_t *search, snps_queue_t *queue);
+static gsize snps_search_bytes(snps_search_t *search, snps_queue_t *queue);
+static snps_state_t *snps_search_state(snps_search_t *search, guint32 index);
+static guint32 snps_game_start(snps_search_t *search);
+static int snps_state_children_queue(guint32 parent, snps_search_t *search,
+    snps_queue_t *todo, unsigned weight);
+static void snps_state_children(guint32 parent, snps_search_t *search,
+    guint32 *ret);
+static guint32 snps_state_move(guint32 parent, snps_search_t *search,
+    unsigned char *board, unsigned char p1, unsigned char p2);
+static unsigned snps_state_estimate(snps_state_t *parent,
+    snps_search_t *search, unsigned char *board, unsigned char p1,
+    unsigned char p2);
+static void snps_frontier_init(snps_frontier_t *frontier,
+    snps_solver_t *solver, int side, snps_game_t *game,
+    snps_profile_t *profile);
+static void snps_frontier_clear(snps_frontier_t *frontier);
+static void snps_frontier_push(snps_frontier_t *frontier, guint32 index);
+static guint32 snps_frontier_top(snps_frontier_t *frontier);
+static int snps_frontier_expand(snps_frontier_t *frontiers, int side,
+    guint32 current, unsigned *best, guint32 *meet);
+static void snps_histogram_add(snps_histogram_t *histogram, unsigned value);
+static unsigned snps_histogram_min(snps_histogram_t *histogram);
+static snps_route_t *snps_route_new(snps_search_t *search, guint32 end,
+    snps_search_t *other, guint32 tail);
+static snps_route_t *snps_route_new_perimeter(snps_search_t *search,
+    guint32 end);
 
 extern snps_game_t *snps_game_new(unsigned rows, unsigned columns,
     const unsigned char *from, const unsigned char *to)
 {
+    if (rows == 0 || columns == 0 || rows * columns > SNPS_SIZE_MAX)
+        return NULL;
+
     snps_game_t *game = g_slice_new(snps_game_t);
     game->rows = rows;
     game->columns = columns;
     game->size = rows * columns;
     game->from = g_slice_copy(game->size, from);
     game->to = g_slice_copy(game->size, to);
+    game->pdb = NULL;
+    game->table = NULL;
+    game->linear_conflict = 0;
+    game->memory_limit = 0;
+    game->perimeter = NULL;
+    game->route_format = SNPS_ROUTE_MOVES;
+    game->kernel = snps_kernel_select(rows, columns);
+    snps_simd_init();
+    snps_heuristic_init(game);
 
     return game;
 }
 
 extern void snps_game_free(snps_game_t *game)
 {
+    if (game->perimeter != NULL)
+        snps_perimeter_release(game->perimeter);
+    snps_heuristic_clear(game);
     g_slice_free1(game->size, game->from);
     g_slice_free1(game->size, game->to);
     g_slice_free(snps_game_t, game);
 }
 
+extern void snps_game_set_pdb(snps_game_t *game, snps_pdb_t *pdb)
+{
+    game->pdb = pdb;
+}
+
+extern void snps_game_set_table(snps_game_t *game, snps_table_t *table)
+{
+    game->table = table;
+}
+
+extern void snps_game_set_linear_conflict(snps_game_t *game, int enabled)
+{
+    game->linear_conflict = enabled;
+}
+
+extern void snps_game_set_memory_limit(snps_game_t *game, size_t bytes)
+{
+    game->memory_limit = bytes;
+}
+
+extern int snps_game_solvable(snps_game_t *game)
+{
+    unsigned size = game->size;
+    unsigned char targets[size], seen[size];
+    int from_blank = -1, to_blank = -1;
+
+    if (game->rows == 0 || game->columns == 0)
+        return 0;
+
+    /* both boards have to contain every tile exactly once */
+    memset(targets, size, size);
+    for (int i = 0; i < size; ++i) {
+        if (game->to[i] >= size || targets[game->to[i]] != size)
+            return 0;
+        targets[game->to[i]] = i;
+    }
+
+    memset(seen, 0, size);
+    for (int i = 0; i < size; ++i) {
+        if (game->from[i] >= size || seen[game->from[i]]++ != 0)
+            return 0;
+        if (game->from[i] == 0)
+            from_blank = i;
+    }
+
+    to_blank = targets[0];
+
+    /* tiles of a single line can't pass each other */
+    if (game->rows == 1 || game->columns == 1) {
+        for (int i = 0, j = 0; i < size && j < size; ++i, ++j) {
+            while (i < size && game->from[i] == 0)
+                ++i;
+            while (j < size && game->to[j] == 0)
+                ++j;
+            if (i < size && j < size && game->from[i] != game->to[j])
+                return 0;
+        }
+
+        return 1;
+    }
+
+    /* every move swaps the blank with a tile, so it flips the parity of the
+       permutation as well as the parity of the blank's distance to its goal
+       cell, both have to match */
+    unsigned cycles = 0;
+    memset(seen, 0, size);
+
+    for (int i = 0; i < size; ++i) {
+        if (seen[i])
+            continue;
+        ++cycles;
+        for (int j = i; !seen[j]; j = targets[game->from[j]])
+            seen[j] = 1;
+    }
+
+    unsigned distance = abs(
+        TRANSLATE_1D_TO_ROW(from_blank, game->columns) -
+        TRANSLATE_1D_TO_ROW(to_blank, game->columns)) + abs(
+        TRANSLATE_1D_TO_COLUMN(from_blank, game->columns) -
+        TRANSLATE_1D_TO_COLUMN(to_blank, game->columns));
+
+    return (size - cycles) % 2 == distance % 2;
+}
+
+extern unsigned snps_game_estimate(snps_game_t *game)
+{
+    return snps_heuristic(game, game->from);
+}
+
 extern snps_route_t *snps_solve_optimal(snps_game_t *game, snps_stats_f stats)
 {
-    GHashTable *state_set = g_hash_table_new_full(snps_state_hash,
-        snps_state_equals, snps_state_free, NULL);
-    GList *level = NULL, *next_level = NULL;
+    snps_settings_t settings = {.callback = stats};
+
+    return snps_run(NULL, game, SNPS_ALGORITHM_OPTIMAL, &settings, NULL);
+}
+
+extern snps_route_t *snps_solve_fast(snps_game_t *game, snps_stats_f stats)
+{
+    snps_settings_t settings = {.callback = stats};
+
+    return snps_run(NULL, game, SNPS_ALGORITHM_FAST, &settings, NULL);
+}
+
+extern snps_route_t *snps_solve_ida(snps_game_t *game, snps_stats_f stats)
+{
+    snps_settings_t settings = {.callback = stats};
+
+    return snps_run(NULL, game, SNPS_ALGORITHM_IDA, &settings, NULL);
+}
+
+extern snps_route_t *snps_solve_bidirectional(snps_game_t *game,
+    snps_stats_f stats)
+{
+    snps_settings_t settings = {.callback = stats};
+
+    return snps_run(NULL, game, SNPS_ALGORITHM_BIDIRECTIONAL, &settings, NULL);
+}
+
+extern snps_route_t *snps_solve_ida_parallel(snps_game_t *game,
+    unsigned threads, snps_stats_t *stats)
+{
+    snps_settings_t settings = {.threads = threads};
+
+    return snps_run(NULL, game, SNPS_ALGORITHM_IDA_PARALLEL, &settings,
+        stats);
+}
+
+extern snps_route_t *snps_solve_fast_parallel(snps_game_t *game,
+    unsigned threads, snps_stats_t *stats)
+{
+    snps_settings_t settings = {.threads = threads};
+
+    return snps_run(NULL, game, SNPS_ALGORITHM_FAST_PARALLEL, &settings,
+        stats);
+}
+
+extern snps_route_t *snps_solve_decompose(snps_game_t *game,
+    snps_stats_t *stats)
+{
+    snps_settings_t settings = {.threads = 0};
+
+    return snps_run(NULL, game, SNPS_ALGORITHM_DECOMPOSE, &settings, stats);
+}
+
+extern snps_route_t *snps_solve(snps_game_t *game,
+    snps_algorithm_t algorithm, snps_stats_t *stats)
+{
+    snps_settings_t settings = {.threads = 0};
+
+    return snps_run(NULL, game, algorithm, &settings, stats);
+}
+
+extern snps_route_t *snps_solve_anytime(snps_game_t *game, double seconds,
+    snps_improved_f improved, void *data, snps_stats_t *stats)
+{
+    snps_settings_t settings = {
+        .improved = improved,
+        .data = data,
+        .budget.deadline = seconds > 0 ? g_get_monotonic_time() +
+            seconds * 1000000 : 0,
+    };
+
+    return snps_run(NULL, game, SNPS_ALGORITHM_ANYTIME, &settings, stats);
+}
+
+extern double snps_clock(void)
+{
+    return g_get_monotonic_time() / 1000000.0;
+}
+
+extern snps_status_t snps_solve_with(snps_game_t *game,
+    const snps_options_t *options, snps_result_t *result)
+{
+    snps_settings_t settings = {
+        .threads = options->threads,
+        .callback = options->callback,
+        .improved = options->improved,
+        .data = options->data,
+        .budget = {
+            .states = options->states,
+            .deadline = options->deadline > 0 ?
+                options->deadline * 1000000 : 0,
+            .cancel = options->cancel,
+            .status = SNPS_STATUS_SOLVED,
+        },
+    };
+
+    snps_route_t *route = snps_run(options->solver, game, options->algorithm,
+        &settings, &result->stats);
+    snps_status_t status = settings.budget.status;
+
+    /* only a memory limit stops an anytime search on its own */
+    if (status == SNPS_STATUS_SOLVED && (route == NULL ||
+        (options->algorithm == SNPS_ALGORITHM_ANYTIME && route->optimal == 0)))
+        status = SNPS_STATUS_EXHAUSTED;
+
+    result->route = route;
+    result->status = status;
+
+    return status;
+}
+
+extern void snps_profile_add(snps_profile_t *profile,
+    const snps_profile_t *other)
+{
+    profile->probes += other->probes;
+    profile->collisions += other->collisions;
+    profile->duplicates += other->duplicates;
+    profile->pushes += other->pushes;
+    profile->pops += other->pops;
+    profile->open_peak = MAX(profile->open_peak, other->open_peak);
+    profile->closed_peak = MAX(profile->closed_peak, other->closed_peak);
+    profile->bytes += other->bytes;
+    profile->estimates += other->estimates;
+    profile->expand_seconds += other->expand_seconds;
+    profile->estimate_seconds += other->estimate_seconds;
+    profile->route_seconds += other->route_seconds;
+}
+
+extern gboolean snps_budget_check(snps_budget_t *budget)
+{
+    if (g_atomic_int_get(&budget->status) != SNPS_STATUS_SOLVED)
+        return TRUE;
+
+    snps_status_t status = SNPS_STATUS_SOLVED;
+
+    if (budget->cancel != NULL && g_atomic_int_get(budget->cancel) != 0)
+        status = SNPS_STATUS_CANCELLED;
+    else if (budget->states != 0 && (guint64) (g_atomic_int_add(
+        &budget->intervals, 1) + 1) * SNPS_BUDGET_INTERVAL >= budget->states)
+        status = SNPS_STATUS_EXHAUSTED;
+    else if (budget->deadline != 0 &&
+        g_get_monotonic_time() >= budget->deadline)
+        status = SNPS_STATUS_EXHAUSTED;
+
+    if (status == SNPS_STATUS_SOLVED)
+        return FALSE;
+
+    g_atomic_int_set(&budget->status, status);
 
-    snps_state_t *start = snps_game_start(game, state_set);
+    return TRUE;
+}
+
+extern snps_solver_t *snps_solver_new(void)
+{
+    snps_solver_t *solver = g_slice_new(snps_solver_t);
+
+    for (int i = 0; i < 2; ++i) {
+        solver->pools[i] = snps_pool_new();
+        solver->sets[i] = snps_set_new(solver->pools[i],
+            G_STRUCT_OFFSET(snps_state_t, key));
+        solver->queues[i] = snps_queue_new();
+    }
+
+    return solver;
+}
+
+extern void snps_solver_free(snps_solver_t *solver)
+{
+    for (int i = 0; i < 2; ++i) {
+        snps_queue_free(solver->queues[i]);
+        snps_set_free(solver->sets[i]);
+        snps_pool_free(solver->pools[i]);
+    }
+
+    g_slice_free(snps_solver_t, solver);
+}
+
+extern snps_route_t *snps_solver_solve(snps_solver_t *solver,
+    snps_game_t *game, snps_algorithm_t algorithm, snps_stats_t *stats)
+{
+    snps_settings_t settings = {.threads = 0};
+
+    return snps_run(solver, game, algorithm, &settings, stats);
+}
+
+/* run one of the solvers on a solvable game, which reports its progress
+   either through a callback or at the end into stats, searches keeping
+   their states use a temporary solver without a given one */
+static snps_route_t *snps_run(snps_solver_t *solver, snps_game_t *game,
+    snps_algorithm_t algorithm, snps_settings_t *settings,
+    snps_stats_t *stats)
+{
+    snps_stats_f callback = settings->callback;
+    gint64 start = g_get_monotonic_time();
+    snps_solver_t *temporary = NULL;
     snps_route_t *route = NULL;
-    level = g_list_prepend(level, start);
 
-    int compared = 0;
-    int expanded = 1;
+    if (stats != NULL)
+        *stats = (snps_stats_t) {0, 0, 0, 0.0};
+
+    if (snps_game_solvable(game) == 0) {
+        settings->budget.status = SNPS_STATUS_UNSOLVABLE;
+        return NULL;
+    }
+
+    /* a table of exact distances leads straight along an optimal route,
+       the searches only run if it doesn't match the game */
+    if (game->table != NULL &&
+        (route = snps_table_walk(game->table, game, stats)) != NULL) {
+        route->optimal = 1;
+        if (algorithm == SNPS_ALGORITHM_ANYTIME && settings->improved != NULL)
+            settings->improved(route, 1.0, settings->data);
+        if (stats != NULL)
+            stats->seconds = (g_get_monotonic_time() - start) / 1000000.0;
+        return route;
+    }
+
+    if (solver == NULL && algorithm != SNPS_ALGORITHM_IDA &&
+        algorithm != SNPS_ALGORITHM_IDA_PARALLEL &&
+        algorithm != SNPS_ALGORITHM_FAST_PARALLEL &&
+        algorithm != SNPS_ALGORITHM_DECOMPOSE)
+        solver = temporary = snps_solver_new();
+
+    switch (algorithm) {
+        case SNPS_ALGORITHM_OPTIMAL:
+            route = snps_run_optimal(solver, game, settings, stats);
+            break;
+        case SNPS_ALGORITHM_FAST:
+            route = snps_run_fast(solver, game, settings, stats);
+            break;
+        case SNPS_ALGORITHM_IDA:
+            route = snps_run_ida(game, callback, &settings->budget, stats);
+            break;
+        case SNPS_ALGORITHM_IDA_PARALLEL:
+            route = snps_run_ida_parallel(game, settings->threads,
+                &settings->budget, stats);
+            break;
+        case SNPS_ALGORITHM_BIDIRECTIONAL:
+            route = snps_run_bidirectional(solver, game, settings, stats);
+            break;
+        case SNPS_ALGORITHM_ANYTIME:
+            route = snps_run_anytime(solver, game, settings, stats);
+            break;
+        case SNPS_ALGORITHM_FAST_PARALLEL:
+            route = snps_run_fast_parallel(game, settings->threads,
+                &settings->budget, stats);
+            break;
+        case SNPS_ALGORITHM_DECOMPOSE:
+            route = snps_run_decompose(game, &settings->budget, stats);
+            break;
+    }
+
+    if (temporary != NULL)
+        snps_solver_free(temporary);
+
+    /* the anytime search knows best whether it finished */
+    if (route != NULL && algorithm != SNPS_ALGORITHM_ANYTIME)
+        route->optimal = algorithm != SNPS_ALGORITHM_FAST &&
+            algorithm != SNPS_ALGORITHM_FAST_PARALLEL &&
+            algorithm != SNPS_ALGORITHM_DECOMPOSE;
+
+    if (stats != NULL)
+        stats->seconds = (g_get_monotonic_time() - start) / 1000000.0;
+
+    return route;
+}
+
+/* a breadth first search level by level, the states of a level are ordered
+   by their estimate so the goal is found first on its level */
+static snps_route_t *snps_run_optimal(snps_solver_t *solver,
+    snps_game_t *game, snps_settings_t *settings, snps_stats_t *stats)
+{
+    return snps_run_best_first(solver, game, 0, settings, stats);
+}
+
+/* a best first search weighting the heuristic twice */
+static snps_route_t *snps_run_fast(snps_solver_t *solver, snps_game_t *game,
+    snps_settings_t *settings, snps_stats_t *stats)
+{
+    return snps_run_best_first(solver, game, 2, settings, stats);
+}
+
+/* expand the states ordered by g plus the weighted heuristic, states are
+   never reopened */
+static snps_route_t *snps_run_best_first(snps_solver_t *solver,
+    snps_game_t *game, unsigned weight, snps_settings_t *settings,
+    snps_stats_t *stats)
+{
+    snps_stats_f callback = settings->callback;
+    snps_stats_t counters = {0, 1, 0, 0.0};
+    snps_search_t search;
+    snps_search_init(&search, solver, 0, game, &counters.profile);
+    snps_queue_t *todo = solver->queues[0];
+    snps_queue_reset(todo);
+
+    snps_perimeter_t *perimeter = game->perimeter;
+    guint32 start = snps_game_start(&search), best = SNPS_NONE;
+    unsigned cost = G_MAXUINT;
+    snps_route_t *route = NULL;
+    snps_queue_push(todo, weight * snps_search_state(&search, start)->h,
+        snps_search_state(&search, start)->h, start);
 
     while (42) {
-        for (GList *item = level; item != NULL; item = item->next) {
-            snps_state_t *current = (snps_state_t *) item->data;
+        guint32 index = snps_queue_pop(todo);
 
-            if (stats != NULL)
-                stats(++compared, expanded, current->g);
+        if (index == SNPS_NONE)
+            break;
 
-            if (memcmp(current->board, game->to, game->size) == 0) {
-                route = snps_route_new(current, game);
+        snps_state_t *current = snps_search_state(&search, index);
+
+        counters.depth = current->g;
+        if (callback != NULL)
+            callback(++counters.compared, counters.expanded, current->g);
+        else
+            ++counters.compared;
+
+        if (snps_budget_stop(&settings->budget, counters.compared))
+            break;
+
+        if (perimeter == NULL && memcmp(current->key, search.goal,
+            search.packing.words * sizeof(guint64)) == 0) {
+            route = snps_route_new(&search, index, NULL, SNPS_NONE);
+            break;
+        }
+
+        /* boards within the perimeter know their exact distance, every
+           route not seen yet leaves the perimeter on the current level at
+           the earliest, so the breadth first search is done once the best
+           route isn't longer, the children of these boards are of no use */
+        if (perimeter != NULL) {
+            unsigned distance = current->h > perimeter->depth ? G_MAXUINT :
+                snps_perimeter_distance(perimeter, current->key);
+
+            if (distance != G_MAXUINT && current->g + distance < cost) {
+                cost = current->g + distance;
+                best = index;
+            }
+
+            if (best != SNPS_NONE && (weight != 0 ||
+                cost <= current->g + perimeter->depth)) {
+                route = snps_route_new_perimeter(&search, best);
                 break;
             }
 
-            expanded += snps_state_children_list(current, game, state_set,
-                &next_level);
+            if (distance != G_MAXUINT)
+                continue;
         }
 
-        g_list_free(level);
-        level = next_level;
-        next_level = NULL;
-
-        if (level == NULL || route != NULL)
+        /* out of memory the breadth first search still knows that no route
+           is shorter than the current level, the best first search goes on
+           from its best open state */
+        if (game->memory_limit != 0 &&
+            snps_search_bytes(&search, todo) >= game->memory_limit) {
+            if (weight == 0) {
+                route = snps_run_ida_from(game, NULL, 0, 1, current->g,
+                    callback, &settings->budget, &counters);
+            } else {
+                snps_route_t *prefix = snps_route_new(&search, index, NULL,
+                    SNPS_NONE);
+                char moves[prefix->length];
+                snps_route_write_moves(prefix, moves);
+                route = snps_run_ida_from(game, moves, prefix->length - 1,
+                    weight, 0, callback, &settings->budget, &counters);
+                snps_route_free(prefix);
+            }
             break;
+        }
+
+        SNPS_PROFILE_START(clock);
+        counters.expanded += snps_state_children_queue(index, &search, todo,
+            weight);
+        SNPS_PROFILE_STOP(&counters.profile, expand_seconds, clock);
     }
-    
-    g_hash_table_destroy(state_set);
-    g_list_free(level);
-    g_list_free(next_level);
+
+    snps_search_profile(&search, todo);
+    snps_search_clear(&search);
+
+    if (stats != NULL)
+        *stats = counters;
 
     return route;
 }
 
-extern snps_route_t *snps_solve_fast(snps_game_t *game, snps_stats_f stats)
+/* a bidirectional search meeting in the middle (MM), both sides expand
+   states by the priority max(f, 2g), which guarantees that they meet
+   halfway along the optimal route, so it's optimal once the best route
+   found is not longer than the lower bound given by the open states */
+static snps_route_t *snps_run_bidirectional(snps_solver_t *solver,
+    snps_game_t *game, snps_settings_t *settings, snps_stats_t *stats)
 {
-    GHashTable *state_set = g_hash_table_new_full(snps_state_hash,
-        snps_state_equals, snps_state_free, NULL);
-    GSequence *todo = g_sequence_new(NULL);
+    snps_stats_f callback = settings->callback;
+    snps_game_t *reverse = snps_game_new(game->rows, game->columns, game->to,
+        game->from);
+    snps_game_set_linear_conflict(reverse, game->linear_conflict);
 
-    snps_state_t *start = snps_game_start(game, state_set);
+    snps_stats_t counters = {0, 2, 0, 0.0};
+    snps_frontier_t frontiers[2];
+    snps_frontier_init(&frontiers[0], solver, 0, game, &counters.profile);
+    snps_frontier_init(&frontiers[1], solver, 1, reverse, &counters.profile);
+
+    guint32 meet[2] = {SNPS_NONE, SNPS_NONE};
     snps_route_t *route = NULL;
-    g_sequence_insert_sorted(todo, start, snps_state_compare, NULL);
+    unsigned best = G_MAXUINT;
 
-    int compared = 0;
-    int expanded = 1;
+    for (int i = 0; i < 2; ++i)
+        snps_frontier_push(&frontiers[i],
+            snps_game_start(&frontiers[i].search));
+
+    if (memcmp(game->from, game->to, game->size) == 0) {
+        meet[0] = snps_frontier_top(&frontiers[0]);
+        meet[1] = snps_frontier_top(&frontiers[1]);
+        best = 0;
+    }
 
     while (42) {
-        GSequenceIter *first = g_sequence_get_begin_iter(todo);
-        
-        if (g_sequence_iter_is_end(first) == TRUE)
+        guint32 tops[2] = {
+            snps_frontier_top(&frontiers[0]),
+            snps_frontier_top(&frontiers[1]),
+        };
+
+        /* one side ran out of states, so every route has been seen */
+        if (tops[0] == SNPS_NONE || tops[1] == SNPS_NONE)
             break;
 
-        snps_state_t *current = g_sequence_get(first);
-        g_sequence_remove(first);
+        unsigned bound = MIN(frontiers[0].open->min, frontiers[1].open->min);
+        bound = MAX(bound, snps_histogram_min(&frontiers[0].f_values));
+        bound = MAX(bound, snps_histogram_min(&frontiers[1].f_values));
+        bound = MAX(bound, snps_histogram_min(&frontiers[0].g_values) +
+            snps_histogram_min(&frontiers[1].g_values) + 1);
 
-        if (stats != NULL);
-            stats(++compared, expanded, current->g);
+        if (best <= bound)
+            break;
 
-        if (memcmp(current->board, game->to, game->size) == 0) {
-            route = snps_route_new(current, game);
+        /* the states of both sides are dropped and the optimal route is
+           searched from scratch, starting at the lower bound found so far */
+        if (game->memory_limit != 0 &&
+            snps_search_bytes(&frontiers[0].search, frontiers[0].open) +
+            snps_search_bytes(&frontiers[1].search, frontiers[1].open) >=
+            game->memory_limit) {
+            meet[0] = SNPS_NONE;
+            route = snps_run_ida_from(game, NULL, 0, 1, bound, callback,
+                &settings->budget, &counters);
             break;
         }
 
-        expanded += snps_state_children_sequence(current, game, state_set,
-            todo);
+        int side = frontiers[0].open->min <= frontiers[1].open->min ? 0 : 1;
+        guint32 current = snps_queue_pop(frontiers[side].open);
+        unsigned g = snps_search_state(&frontiers[side].search, current)->g;
+
+        counters.depth = g;
+        if (callback != NULL)
+            callback(++counters.compared, counters.expanded, g);
+        else
+            ++counters.compared;
+
+        if (snps_budget_stop(&settings->budget, counters.compared)) {
+            meet[0] = SNPS_NONE;
+            break;
+        }
+
+        SNPS_PROFILE_START(clock);
+        counters.expanded += snps_frontier_expand(frontiers, side, current,
+            &best, meet);
+        SNPS_PROFILE_STOP(&counters.profile, expand_seconds, clock);
     }
 
-    g_sequence_free(todo);
-    g_hash_table_destroy(state_set);
+    if (meet[0] != SNPS_NONE)
+        route = snps_route_new(&frontiers[0].search, meet[0],
+            &frontiers[1].search, meet[1]);
+
+    snps_search_profile(&frontiers[0].search, frontiers[0].open);
+    snps_search_profile(&frontiers[1].search, frontiers[1].open);
+    snps_frontier_clear(&frontiers[1]);
+    snps_frontier_clear(&frontiers[0]);
+    snps_game_free(reverse);
+
+    if (stats != NULL)
+        *stats = counters;
 
     return route;
 }
 
-extern void snps_route_free(snps_route_t *route)
+/* an anytime repairing A* search (ARA*), a search with a large weight on
+   the heuristic finds a first route quickly, then the weight is lowered
+   step by step and the search continues with the states it already knows,
+   states reached on a shorter route after their expansion wait for the
+   next iteration, every better route is handed over along with a bound of
+   how much longer than the optimal one it may be */
+static snps_route_t *snps_run_anytime(snps_solver_t *solver,
+    snps_game_t *game, snps_settings_t *settings, snps_stats_t *stats)
 {
-    for (int i = 0; i < route->length; ++i)
-        g_slice_free1(route->size, route->boards[i]);
-    g_slice_free1(route->length * sizeof(char *), route->boards);
-    g_slice_free1(route->length, route->moves);
-    g_slice_free(snps_route_t, route);
-}
+    snps_stats_t counters = {0, 1, 0, 0.0};
+    snps_search_t search;
+    snps_search_init(&search, solver, 0, game, &counters.profile);
+    snps_queue_t *open = solver->queues[0];
+    snps_queue_reset(open);
+
+    unsigned weight = SNPS_ANYTIME_WEIGHT, cost = G_MAXUINT;
+    unsigned reported = G_MAXUINT;
+    double bound = G_MAXDOUBLE;
+    guint32 goal = SNPS_NONE;
+    snps_route_t *route = NULL;
+    gboolean stopped = FALSE, exceeded = FALSE;
+
+    guint32 start = snps_game_start(&search);
+    snps_state_t *first = snps_search_state(&search, start);
+    snps_queue_push(open, weight * first->h, first->h, start);
+    if (memcmp(first->key, search.goal,
+        search.packing.words * sizeof(guint64)) == 0) {
+        cost = 0;
+        goal = start;
+    }
 
-/* create a first state using the start board */
-static snps_state_t *snps_game_start(snps_game_t *game, GHashTable *state_set)
-{
-    snps_state_t *start = g_slice_new(snps_state_t);
-    start->parent = NULL;
-    start->size = game->size;
-    start->board = g_slice_copy(game->size, game->from);
-    start->g = start->h = start->f = 0;
+    while (42) {
+        /* expand states until none of them may lead to a better route */
+        while (stopped == FALSE) {
+            guint32 index = snps_queue_peek(open);
 
-    g_hash_table_insert(state_set, start, start);
+            if (index == SNPS_NONE)
+                break;
 
-    return start;
+            snps_state_t *current = snps_search_state(&search, index);
+
+            if (current->list != SNPS_LIST_OPEN) {
+                snps_queue_pop(open);
+                continue;
+            }
+
+            if (cost != G_MAXUINT && open->min >= SNPS_ANYTIME_SCALE * cost)
+                break;
+
+            snps_queue_pop(open);
+            current->list = SNPS_LIST_CLOSED;
+
+            counters.depth = current->g;
+            if (settings->callback != NULL)
+                settings->callback(++counters.compared, counters.expanded,
+                    current->g);
+            else
+                ++counters.compared;
+
+            SNPS_PROFILE_START(clock);
+            counters.expanded += snps_anytime_expand(&search, open, index,
+                weight, &cost, &goal);
+            SNPS_PROFILE_STOP(&counters.profile, expand_seconds, clock);
+
+            if (snps_budget_stop(&settings->budget, counters.compared))
+                stopped = TRUE;
+            else if ((counters.compared & 1023) == 0 &&
+                game->memory_limit != 0 &&
+                snps_search_bytes(&search, open) >= game->memory_limit)
+                stopped = exceeded = TRUE;
+        }
+
+        /* the lowest estimate of the states which may still lead to a
+           shorter route bounds the optimal length from below */
+        unsigned previous = weight;
+        if (stopped == FALSE)
+            weight = MAX(weight - SNPS_ANYTIME_STEP, SNPS_ANYTIME_SCALE);
+        unsigned lower = snps_anytime_rebuild(&search, open, weight);
+
+        if (goal != SNPS_NONE) {
+            /* only a pass which ran to the end proves its weight, a
+               stopped one leaves the estimate of the open states */
+            double tighter = lower == G_MAXUINT ? 1.0 :
+                (double) cost / lower;
+            gboolean proven = lower == G_MAXUINT || lower >= cost;
+            if (stopped == FALSE) {
+                tighter = MIN(tighter, (double) previous /
+                    SNPS_ANYTIME_SCALE);
+                proven |= previous == SNPS_ANYTIME_SCALE;
+            }
+            tighter = MAX(tighter, 1.0);
+
+            if (cost < reported) {
+                if (route != NULL)
+                    snps_route_free(route);
+                route = snps_route_new(&search, goal, NULL, SNPS_NONE);
+            }
+
+            if (cost < reported || tighter < bound) {
+                reported = cost;
+                bound = MIN(bound, tighter);
+                route->optimal = proven;
+                if (settings->improved != NULL)
+                    settings->improved(route, bound, settings->data);
+            }
+        }
+
+        if (stopped || lower == G_MAXUINT || lower >= cost ||
+            previous == SNPS_ANYTIME_SCALE)
+            break;
+    }
+
+    /* out of memory before the first route it starts over with a weighted
+       search without keeping states, its weight rounded up to a whole
+       number, the route of a prefix of open states wouldn't keep that
+       bound */
+    if (exceeded && route == NULL) {
+        unsigned ida_weight = (weight + SNPS_ANYTIME_SCALE - 1) /
+            SNPS_ANYTIME_SCALE;
+
+        route = snps_run_ida_from(game, NULL, 0, ida_weight, 0,
+            settings->callback, &settings->budget, &counters);
+
+        if (route != NULL) {
+            route->optimal = ida_weight == 1;
+            if (settings->improved != NULL)
+                settings->improved(route, ida_weight, settings->data);
+        }
+    }
+
+    snps_search_profile(&search, open);
+    snps_search_clear(&search);
+
+    if (stats != NULL)
+        *stats = counters;
+
+    return route;
 }
 
-/* add all possible following states to a list */
-static int snps_state_children_list(snps_state_t *parent,
-    snps_game_t *game, GHashTable *state_set, GList **list)
+/* open all children of a state of an anytime search unless they are known
+   with a route at least as short, closed ones become inconsistent instead,
+   a shorter route to the goal updates its cost */
+static int snps_anytime_expand(snps_search_t *search, snps_queue_t *open,
+    guint32 current, unsigned weight, unsigned *cost, guint32 *goal)
 {
-    snps_state_t *children[4] = {NULL, NULL, NULL, NULL};
-    snps_state_children(parent, game, state_set, children);
+    snps_state_t *parent = snps_search_state(search, current);
+    snps_game_t *game = search->game;
+    unsigned words = search->packing.words;
+    unsigned char board[game->size];
+    int cells[4], count = 0;
 
-    int count = 0;
+    snps_key_unpack(&search->packing, parent->key, board);
+    snps_neighbours(game, parent->blank, cells);
 
-    for (int i = 0; i < 4; ++i)
-        if (children[i] != NULL) {
-            *list = g_list_prepend(*list, children[i]);
+    for (int i = 0; i < 4; ++i) {
+        if (cells[i] < 0)
+            continue;
+
+        guint64 key[words];
+        memcpy(key, parent->key, words * sizeof(guint64));
+        snps_key_move(&search->packing, key, parent->blank, cells[i]);
+
+        snps_slot_t *slot = snps_set_slot(search->state_set, key);
+        guint32 index = snps_set_item(search->state_set, slot);
+        snps_state_t *state;
+
+        if (index != SNPS_NONE)
+            SNPS_PROFILE_ADD(search->profile, duplicates, 1);
+
+        if (index == SNPS_NONE) {
+            index = snps_pool_alloc(search->pool);
+            state = snps_search_state(search, index);
+            state->blank = cells[i];
+            state->list = SNPS_LIST_NONE;
+            state->h = snps_state_estimate(parent, search, board,
+                parent->blank, cells[i]);
+            memcpy(state->key, key, words * sizeof(guint64));
+            snps_set_fill(search->state_set, slot, key, index);
+        } else if ((state = snps_search_state(search, index))->g <=
+            parent->g + 1) {
+            continue;
+        }
+
+        state->parent = current;
+        state->g = parent->g + 1;
+
+        if (state->list == SNPS_LIST_CLOSED) {
+            state->list = SNPS_LIST_INCONSISTENT;
+        } else if (state->list != SNPS_LIST_INCONSISTENT) {
+            state->list = SNPS_LIST_OPEN;
+            snps_queue_push(open, SNPS_ANYTIME_SCALE * state->g +
+                weight * state->h, state->h, index);
             ++count;
         }
 
+        if (state->g < *cost && memcmp(key, search->goal,
+            words * sizeof(guint64)) == 0) {
+            *cost = state->g;
+            *goal = index;
+        }
+    }
+
     return count;
 }
 
-/* add all possible following states to a sequence */
-static int snps_state_children_sequence(snps_state_t *parent,
-    snps_game_t *game, GHashTable *state_set, GSequence *todo)
+/* open the open and inconsistent states of an anytime search again ordered
+   by a new weight and forget which ones were closed, returns the lowest
+   g + h of the opened states */
+static unsigned snps_anytime_rebuild(snps_search_t *search,
+    snps_queue_t *open, unsigned weight)
 {
-    snps_state_t *children[4] = {NULL, NULL, NULL, NULL};
-    snps_state_children(parent, game, state_set, children);
+    unsigned lower = G_MAXUINT;
+
+    snps_queue_reset(open);
+
+    for (guint32 i = 0; i < search->pool->count; ++i) {
+        snps_state_t *state = snps_search_state(search, i);
+
+        if (state->list == SNPS_LIST_CLOSED)
+            state->list = SNPS_LIST_NONE;
+
+        if (state->list == SNPS_LIST_NONE)
+            continue;
+
+        state->list = SNPS_LIST_OPEN;
+        lower = MIN(lower, state->g + state->h);
+        snps_queue_push(open, SNPS_ANYTIME_SCALE * state->g +
+            weight * state->h, state->h, i);
+    }
+
+    return lower;
+}
+
+/* prepare a search using the pool and state set of one side of a solver */
+static void snps_search_init(snps_search_t *search, snps_solver_t *solver,
+    int side, snps_game_t *game, snps_profile_t *profile)
+{
+    search->game = game;
+    search->profile = profile;
+    snps_packing_init(&search->packing, game->size);
+    search->pool = solver->pools[side];
+    snps_pool_reset(search->pool, sizeof(snps_state_t) +
+        search->packing.words * sizeof(guint64));
+    search->state_set = solver->sets[side];
+    snps_set_reset(search->state_set, search->packing.words);
+    search->state_set->profile = profile;
+    solver->queues[side]->profile = profile;
+    search->goal = g_new(guint64, search->packing.words);
+    snps_key_pack(&search->packing, search->goal, game->to);
+}
+
+/* release what a search doesn't leave to its solver */
+static void snps_search_clear(snps_search_t *search)
+{
+    g_free(search->goal);
+}
+
+/* note how many states a search kept and their memory in its profile */
+static void snps_search_profile(snps_search_t *search, snps_queue_t *queue)
+{
+    SNPS_PROFILE_PEAK(search->profile, closed_peak,
+        search->state_set->count);
+    SNPS_PROFILE_ADD(search->profile, bytes,
+        snps_search_bytes(search, queue));
+}
+
+/* bytes used by the states of a search and its queue, the set is rated at
+   the load it has right after growing */
+static gsize snps_search_bytes(snps_search_t *search, snps_queue_t *queue)
+{
+    return (gsize) search->pool->count * search->pool->item_size +
+        2 * search->state_set->count * sizeof(snps_slot_t) +
+        queue->count * sizeof(guint32);
+}
+
+/* the state at an index of a search */
+static snps_state_t *snps_search_state(snps_search_t *search, guint32 index)
+{
+    return (snps_state_t *) snps_pool_get(search->pool, index);
+}
+
+/* create a first state using the start board */
+static guint32 snps_game_start(snps_search_t *search)
+{
+    snps_game_t *game = search->game;
+    guint32 index = snps_pool_alloc(search->pool);
+    snps_state_t *start = snps_search_state(search, index);
+    start->parent = SNPS_NONE;
+    start->g = 0;
+    start->h = snps_heuristic(game, game->from);
+    SNPS_PROFILE_ADD(search->profile, estimates, 1);
+    start->blank = 0;
+    start->list = SNPS_LIST_OPEN;
+    while (game->from[start->blank] != 0)
+        ++start->blank;
+    snps_key_pack(&search->packing, start->key, game->from);
+
+    snps_set_fill(search->state_set, snps_set_slot(search->state_set,
+        start->key), start->key, index);
+
+    return index;
+}
+
+/* add all possible following states to a queue, ordered by g plus the
+   weighted heuristic */
+static int snps_state_children_queue(guint32 parent, snps_search_t *search,
+    snps_queue_t *todo, unsigned weight)
+{
+    guint32 children[4] = {SNPS_NONE, SNPS_NONE, SNPS_NONE, SNPS_NONE};
+    snps_state_children(parent, search, children);
 
     int count = 0;
 
     for (int i = 0; i < 4; ++i)
-        if (children[i] != NULL) {
-            g_sequence_insert_sorted(todo, children[i], snps_state_compare,
-                NULL);
+        if (children[i] != SNPS_NONE) {
+            snps_state_t *child = snps_search_state(search, children[i]);
+            snps_queue_push(todo, child->g + weight * child->h, child->h,
+                children[i]);
             ++count;
         }
 
@@ -220,184 +1070,298 @@ static int snps_state_children_sequence(snps_state_t *parent,
 }
 
 /* creates all possible following states */
-static void snps_state_children(snps_state_t *parent, snps_game_t *game,
-    GHashTable *state_set, snps_state_t **ret)
-{
-    int p = 0;
-    while (parent->board[p] != 0)
-        ++p;
-
-    int row = TRANSLATE_1D_TO_ROW(p, game->columns);
-    int column = TRANSLATE_1D_TO_COLUMN(p, game->columns);
-    
-    if (column > 0)
-        ret[0] = snps_state_move(parent, game, state_set, p,
-            TRANSLATE_2D_TO_1D(row, column - 1, game->rows));
-    if (column < (game->columns - 1))
-        ret[1] = snps_state_move(parent, game, state_set, p,
-            TRANSLATE_2D_TO_1D(row, column + 1, game->rows));
-    if (row > 0)
-        ret[2] = snps_state_move(parent, game, state_set, p,
-            TRANSLATE_2D_TO_1D(row - 1, column, game->rows));
-    if (row < (game->rows - 1))
-        ret[3] = snps_state_move(parent, game, state_set, p,
-            TRANSLATE_2D_TO_1D(row + 1, column, game->rows));
-}
-
-/* tries to create a new state if it doesn't already exist */
-static snps_state_t *snps_state_move(snps_state_t *parent, snps_game_t *game,
-    GHashTable *state_set, unsigned char p1, unsigned char p2)
-{
-    unsigned char board[parent->size];
-    memcpy(board, parent->board, parent->size);
-    board[p1] = board[p2];
-    board[p2] = 0;
-
-    snps_state_t tmp = {
-        .board = board,
-        .size = parent->size,
-    };
-
-    if (g_hash_table_lookup(state_set, &tmp) != NULL)
-        return NULL;
-
-    snps_state_t *state = g_slice_new(snps_state_t);
-    state->parent = parent;
-    state->size = parent->size;
-    state->board = g_slice_copy(parent->size, board);
-    state->g = parent->g + 1;
-    state->h = snps_state_heuristic(state, game);
-    state->f = state->g + 2 * state->h;
+static void snps_state_children(guint32 parent, snps_search_t *search,
+    guint32 *ret)
+{
+    snps_game_t *game = search->game;
+    snps_state_t *state = snps_search_state(search, parent);
+    unsigned char board[game->size];
+    snps_key_unpack(&search->packing, state->key, board);
 
-    g_hash_table_insert(state_set, state, state);
+    int cells[4];
+    snps_neighbours(game, state->blank, cells);
 
-    return state;
+    for (int i = 0; i < 4; ++i)
+        if (cells[i] >= 0)
+            ret[i] = snps_state_move(parent, search, board, state->blank,
+                cells[i]);
 }
 
-/* a simple heuristic to rate a state */
-static unsigned snps_state_heuristic(snps_state_t *state, snps_game_t *game)
+/* tries to create a new state if it doesn't already exist, board holds the
+   unpacked board of the parent */
+static guint32 snps_state_move(guint32 parent, snps_search_t *search,
+    unsigned char *board, unsigned char p1, unsigned char p2)
 {
-    unsigned h = 0;
-    unsigned i_current, diff_columns, diff_rows;
+    snps_state_t *from = snps_search_state(search, parent);
+    guint64 key[search->packing.words];
+    memcpy(key, from->key, search->packing.words * sizeof(guint64));
+    snps_key_move(&search->packing, key, p1, p2);
+
+    snps_slot_t *slot = snps_set_slot(search->state_set, key);
+    if (snps_set_item(search->state_set, slot) != SNPS_NONE) {
+        SNPS_PROFILE_ADD(search->profile, duplicates, 1);
+        return SNPS_NONE;
+    }
 
-    for (int i = 0; i < game->size; ++i) {
-        if (game->to[i] == 0 || state->board[i] == game->to[i])
-            continue;
+    guint32 index = snps_pool_alloc(search->pool);
+    snps_state_t *state = snps_search_state(search, index);
+    state->parent = parent;
+    state->blank = p2;
+    state->list = SNPS_LIST_OPEN;
+    memcpy(state->key, key, search->packing.words * sizeof(guint64));
+    state->g = from->g + 1;
+    state->h = snps_state_estimate(from, search, board, p1, p2);
 
-        for (i_current = 0; state->board[i_current] != game->to[i];
-            ++i_current)
-            ;
+    snps_set_fill(search->state_set, slot, key, index);
+
+    return index;
+}
 
-        diff_columns = abs(TRANSLATE_1D_TO_COLUMN(i, game->columns) - 
-            TRANSLATE_1D_TO_COLUMN(i_current, game->columns));
-        diff_rows = abs(TRANSLATE_1D_TO_ROW(i, game->columns) - 
-            TRANSLATE_1D_TO_ROW(i_current, game->columns));
-        
-        h += diff_rows + diff_columns;
+/* estimated distance of a child created by sliding the tile at p2 into the
+   blank at p1 of the parent's unpacked board */
+static unsigned snps_state_estimate(snps_state_t *parent,
+    snps_search_t *search, unsigned char *board, unsigned char p1,
+    unsigned char p2)
+{
+    unsigned h;
+
+    SNPS_PROFILE_START(clock);
+    SNPS_PROFILE_ADD(search->profile, estimates, 1);
+
+    if (search->game->pdb == NULL) {
+        h = snps_heuristic_move(search->game, board, parent->h, p1, p2);
+    } else {
+        board[p1] = board[p2];
+        board[p2] = 0;
+        h = snps_heuristic(search->game, board);
+        board[p2] = board[p1];
+        board[p1] = 0;
     }
 
+    SNPS_PROFILE_STOP(search->profile, estimate_seconds, clock);
+
     return h;
 }
 
-/* creates a pseudo hash of a board using the SDBM algorithm */
-static guint snps_state_hash(gconstpointer a)
+/* prepare one side of a bidirectional search */
+static void snps_frontier_init(snps_frontier_t *frontier,
+    snps_solver_t *solver, int side, snps_game_t *game,
+    snps_profile_t *profile)
 {
-    guint hash = 0;
-    snps_state_t *state = (snps_state_t *) a;
+    snps_search_init(&frontier->search, solver, side, game, profile);
+    frontier->open = solver->queues[side];
+    snps_queue_reset(frontier->open);
+    frontier->g_values = (snps_histogram_t) {NULL, 0, G_MAXUINT};
+    frontier->f_values = (snps_histogram_t) {NULL, 0, G_MAXUINT};
+}
 
-    for (int i = 0; i < state->size; ++i)
-        hash = (guint) state->board[i] + (hash << 6) + (hash << 16) - hash;
+/* free one side of a bidirectional search */
+static void snps_frontier_clear(snps_frontier_t *frontier)
+{
+    g_free(frontier->f_values.counts);
+    g_free(frontier->g_values.counts);
+    snps_search_clear(&frontier->search);
+}
 
-    return hash;
+/* open a state with the priority max(f, 2g) */
+static void snps_frontier_push(snps_frontier_t *frontier, guint32 index)
+{
+    snps_state_t *state = snps_search_state(&frontier->search, index);
+    unsigned f = state->g + state->h;
+
+    state->list = SNPS_LIST_OPEN;
+    snps_histogram_add(&frontier->g_values, state->g);
+    snps_histogram_add(&frontier->f_values, f);
+    snps_queue_push(frontier->open, MAX(f, 2 * state->g), state->h, index);
 }
 
-/* compare two boards on equality */
-static gboolean snps_state_equals(gconstpointer a, gconstpointer b)
+/* the open state with the lowest priority, entries left behind by states
+   reached again on a shorter route are dropped on the way */
+static guint32 snps_frontier_top(snps_frontier_t *frontier)
 {
-    snps_state_t *state_a = (snps_state_t *) a;
-    snps_state_t *state_b = (snps_state_t *) b;
+    guint32 index;
 
-    if (memcmp(state_a->board, state_b->board, state_a->size) == 0)
-        return TRUE;
+    while ((index = snps_queue_peek(frontier->open)) != SNPS_NONE &&
+        snps_search_state(&frontier->search, index)->list ==
+        SNPS_LIST_CLOSED)
+        snps_queue_pop(frontier->open);
 
-    return FALSE;
+    return index;
 }
 
-/* compare two states */
-static gint snps_state_compare(gconstpointer a, gconstpointer b,
-    gpointer user_data)
+/* close a state and open its children unless they are already known with
+   a shorter route, routes meeting the other side update the best one and
+   its forward and backward half */
+static int snps_frontier_expand(snps_frontier_t *frontiers, int side,
+    guint32 current, unsigned *best, guint32 *meet)
 {
-    snps_state_t *state_a = (snps_state_t *) a;
-    snps_state_t *state_b = (snps_state_t *) b;
+    snps_frontier_t *frontier = frontiers + side;
+    snps_frontier_t *other = frontiers + 1 - side;
+    snps_search_t *search = &frontier->search;
+    snps_state_t *parent = snps_search_state(search, current);
+    snps_game_t *game = search->game;
+    unsigned words = search->packing.words;
+    unsigned char board[game->size];
+    int cells[4], count = 0;
+
+    parent->list = SNPS_LIST_CLOSED;
+    --frontier->g_values.counts[parent->g];
+    --frontier->f_values.counts[parent->g + parent->h];
+
+    snps_key_unpack(&search->packing, parent->key, board);
+    snps_neighbours(game, parent->blank, cells);
+
+    for (int i = 0; i < 4; ++i) {
+        if (cells[i] < 0)
+            continue;
 
-    if (state_a->f > state_b->f)
-        return 1;
-    if (state_a->f < state_b->f)
-        return -1;
+        guint64 key[words];
+        memcpy(key, parent->key, words * sizeof(guint64));
+        snps_key_move(&search->packing, key, parent->blank, cells[i]);
+
+        snps_slot_t *slot = snps_set_slot(search->state_set, key);
+        guint32 index = snps_set_item(search->state_set, slot);
+        snps_state_t *state;
+
+        if (index != SNPS_NONE)
+            SNPS_PROFILE_ADD(search->profile, duplicates, 1);
+
+        if (index == SNPS_NONE) {
+            index = snps_pool_alloc(search->pool);
+            state = snps_search_state(search, index);
+            state->blank = cells[i];
+            state->h = snps_state_estimate(parent, search, board,
+                parent->blank, cells[i]);
+            memcpy(state->key, key, words * sizeof(guint64));
+            snps_set_fill(search->state_set, slot, key, index);
+        } else if ((state = snps_search_state(search, index))->g <=
+            parent->g + 1) {
+            continue;
+        } else if (state->list == SNPS_LIST_OPEN) {
+            --frontier->g_values.counts[state->g];
+            --frontier->f_values.counts[state->g + state->h];
+        }
+
+        state->parent = current;
+        state->g = parent->g + 1;
+        snps_frontier_push(frontier, index);
+        ++count;
+
+        guint32 match = snps_set_find(other->search.state_set, key);
+        if (match == SNPS_NONE)
+            continue;
+
+        unsigned length = state->g +
+            snps_search_state(&other->search, match)->g;
+        if (length < *best) {
+            *best = length;
+            meet[side] = index;
+            meet[1 - side] = match;
+        }
+    }
 
-    return 0;
+    return count;
 }
 
-/* free a state */
-static void snps_state_free(gpointer data)
+/* count a value */
+static void snps_histogram_add(snps_histogram_t *histogram, unsigned value)
 {
-    snps_state_t *state = (snps_state_t *) data;
+    if (value >= histogram->capacity) {
+        unsigned capacity = MAX(2 * histogram->capacity, value + 64);
+        histogram->counts = g_renew(unsigned, histogram->counts, capacity);
+        memset(histogram->counts + histogram->capacity, 0,
+            (capacity - histogram->capacity) * sizeof(unsigned));
+        histogram->capacity = capacity;
+    }
 
-    g_slice_free1(state->size, state->board);
-    g_slice_free(snps_state_t, state);
+    ++histogram->counts[value];
+    if (value < histogram->min)
+        histogram->min = value;
 }
 
-/* create a new route by reversing the final state */
-static snps_route_t *snps_route_new(snps_state_t *end, snps_game_t *game)
+/* the lowest value counted at least once, G_MAXUINT if there is none */
+static unsigned snps_histogram_min(snps_histogram_t *histogram)
 {
-    GList *list = NULL;
-    for (snps_state_t *state = end; state != NULL; state = state->parent)
-        list = g_list_prepend(list, state);
+    while (histogram->min < histogram->capacity &&
+        histogram->counts[histogram->min] == 0)
+        ++histogram->min;
 
-    snps_route_t *route = g_slice_new(snps_route_t);
-    route->length = g_list_length(list);
-    route->size = end->size;
-    route->boards = g_slice_alloc(route->length * sizeof(char *));
-    route->moves = g_slice_alloc(route->length);
-    route->moves[route->length - 1] = '\0';
+    return histogram->min < histogram->capacity ? histogram->min : G_MAXUINT;
+}
 
-    int i = -1;
-    for (GList *item = list; item != NULL; item = item->next) {
-        route->boards[++i] = g_slice_copy(end->size,
-            ((snps_state_t *) item->data)->board);
+/* create a new route by reversing the final state, a tail reached from the
+   other side of a bidirectional search leads on to the goal */
+static snps_route_t *snps_route_new(snps_search_t *search, guint32 end,
+    snps_search_t *other, guint32 tail)
+{
+    SNPS_PROFILE_START(clock);
+    snps_game_t *game = search->game;
+    unsigned count = 0;
+    guint32 first = end;
+
+    while (snps_search_state(search, first)->parent != SNPS_NONE) {
+        first = snps_search_state(search, first)->parent;
+        ++count;
+    }
 
-        if (item->next == NULL)
-            continue;
+    unsigned head = count;
+    if (tail != SNPS_NONE) {
+        for (guint32 index = snps_search_state(other, tail)->parent;
+            index != SNPS_NONE;
+            index = snps_search_state(other, index)->parent)
+            ++count;
+    }
 
-        snps_state_t *from = (snps_state_t *) item->data;
-        snps_state_t *to = (snps_state_t *) item->next->data;
-
-        int from_p = 0;
-        while (from->board[from_p] != 0)
-            ++from_p;
-
-        int to_p = 0;
-        while (to->board[to_p] != 0)
-            ++to_p;
-
-        int from_p_row = TRANSLATE_1D_TO_ROW(from_p, game->columns);
-        int from_p_column = TRANSLATE_1D_TO_COLUMN(from_p, game->columns);
-        int to_p_row = TRANSLATE_1D_TO_ROW(to_p, game->columns);
-        int to_p_column = TRANSLATE_1D_TO_COLUMN(to_p, game->columns);
-        
-        if (from_p_row > to_p_row)
-            route->moves[i] = 'U';
-        else if (from_p_row < to_p_row)
-            route->moves[i] = 'D';
-        else if (from_p_column > to_p_column)
-            route->moves[i] = 'L';
-        else
-            route->moves[i] = 'R';
+    unsigned char start[game->size];
+    snps_key_unpack(&search->packing, snps_search_state(search, first)->key,
+        start);
+    snps_route_t *route = snps_route_alloc(game, start, count);
+
+    /* the moves up to the final state are set backwards */
+    snps_state_t *to = snps_search_state(search, end);
+    for (unsigned i = head; i > 0; --i) {
+        snps_state_t *from = snps_search_state(search, to->parent);
+        snps_route_set_move(route, i - 1,
+            snps_route_direction(game, from->blank, to->blank));
+        to = from;
     }
 
-    g_list_free(list);
+    if (tail != SNPS_NONE) {
+        snps_state_t *from = snps_search_state(search, end);
+        unsigned i = head;
+        for (guint32 index = snps_search_state(other, tail)->parent;
+            index != SNPS_NONE;
+            index = snps_search_state(other, index)->parent) {
+            to = snps_search_state(other, index);
+            snps_route_set_move(route, i++,
+                snps_route_direction(game, from->blank, to->blank));
+            from = to;
+        }
+    }
+
+    snps_route_complete(game, route);
+
+    SNPS_PROFILE_STOP(search->profile, route_seconds, clock);
 
     return route;
 }
 
+/* create a new route to a board of the perimeter of the goal board, which
+   continues along the perimeter */
+static snps_route_t *snps_route_new_perimeter(snps_search_t *search,
+    guint32 end)
+{
+    snps_perimeter_t *perimeter = search->game->perimeter;
+    snps_route_t *prefix = snps_route_new(search, end, NULL, SNPS_NONE);
+    unsigned count = prefix->length - 1;
+    char moves[count + perimeter->depth + 1];
+
+    snps_route_write_moves(prefix, moves);
+    count += snps_perimeter_moves(search->game,
+        snps_search_state(search, end)->key, moves + count);
+    snps_route_free(prefix);
+
+    return snps_route_new_moves(search->game, moves, count);
+}
+
 /* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -25,35 +25,270 @@
 #ifndef SNPS_H
 #define SNPS_H
 
+#include <stddef.h>
+
 /* datatypes */
+typedef struct snps_pdb snps_pdb_t;
+typedef struct snps_solver snps_solver_t;
+typedef struct snps_perimeter snps_perimeter_t;
+typedef struct snps_table snps_table_t;
+typedef struct snps_generator snps_generator_t;
+
 typedef struct {
     unsigned char rows;
     unsigned char columns;
     unsigned char size;
     unsigned char *from;
     unsigned char *to;
+    snps_pdb_t *pdb;
+    snps_table_t *table;
+    int linear_conflict;
+    size_t memory_limit;
+    snps_perimeter_t *perimeter;
+    unsigned route_format;
+    /* the search code specialised for the size of the board */
+    unsigned char kernel;
+    /* lookup tables created by snps_game_new, the distance of every tile
+       on every cell to its goal cell and the goal cell of every tile */
+    unsigned char *distances;
+    unsigned char *goal_rows;
+    unsigned char *goal_columns;
+    /* the row and column of every cell */
+    unsigned char *cell_rows;
+    unsigned char *cell_columns;
 } snps_game_t;
 
+/* the representations of a route filled in by the solvers besides the
+   start board and the moves packed into two bits each */
+typedef enum {
+    SNPS_ROUTE_MOVES = 1 << 0,
+    SNPS_ROUTE_BOARDS = 1 << 1,
+} snps_route_format_t;
+
 typedef struct {
+    /* every board along the route, NULL without SNPS_ROUTE_BOARDS */
     unsigned char **boards;
+    /* the moves of the blank as string of L, R, U and D, NULL without
+       SNPS_ROUTE_MOVES */
     unsigned char *moves;
     unsigned size;
+    /* the number of boards, one more than the number of moves */
     unsigned length;
+    /* whether no shorter route exists */
+    int optimal;
+    unsigned columns;
+    unsigned char *start;
+    unsigned char *packed;
 } snps_route_t;
 
+/* walks along the boards of a route, board holds the board at index */
+typedef struct {
+    const snps_route_t *route;
+    unsigned char *board;
+    unsigned index;
+    unsigned blank;
+} snps_route_iter_t;
+
 typedef void (*snps_stats_f)(unsigned states_compared,
     unsigned states_expanded, unsigned depth);
 
+/* receives every better route of an anytime search, which is at most bound
+   times as long as the optimal one */
+typedef void (*snps_improved_f)(const snps_route_t *route, double bound,
+    void *data);
+
+typedef enum {
+    SNPS_ALGORITHM_OPTIMAL,
+    SNPS_ALGORITHM_FAST,
+    SNPS_ALGORITHM_IDA,
+    SNPS_ALGORITHM_IDA_PARALLEL,
+    SNPS_ALGORITHM_BIDIRECTIONAL,
+    SNPS_ALGORITHM_ANYTIME,
+    SNPS_ALGORITHM_FAST_PARALLEL,
+    SNPS_ALGORITHM_DECOMPOSE,
+} snps_algorithm_t;
+
+/* detailed counters of a search, which are only kept by a library built
+   with SNPS_PROFILE defined, probes count the slots of the state sets looked
+   at and collisions those holding another state, duplicates are children
+   known already, the peaks and bytes are those of the states kept, the time
+   spent expanding states includes the time spent estimating distances */
+typedef struct {
+    unsigned long long probes;
+    unsigned long long collisions;
+    unsigned long long duplicates;
+    unsigned long long pushes;
+    unsigned long long pops;
+    unsigned long long open_peak;
+    unsigned long long closed_peak;
+    unsigned long long bytes;
+    unsigned long long estimates;
+    double expand_seconds;
+    double estimate_seconds;
+    double route_seconds;
+} snps_profile_t;
+
+typedef struct {
+    unsigned compared;
+    unsigned expanded;
+    unsigned depth;
+    double seconds;
+    snps_profile_t profile;
+} snps_stats_t;
+
+/* why a search ended, a search running out of its budget or cancelled
+   returns no route, except for the anytime search */
+typedef enum {
+    SNPS_STATUS_SOLVED,
+    SNPS_STATUS_UNSOLVABLE,
+    SNPS_STATUS_EXHAUSTED,
+    SNPS_STATUS_CANCELLED,
+} snps_status_t;
+
+/* how snps_solve_with runs a search, the budget is checked every 256 states
+   and shared by all threads of a search */
+typedef struct {
+    snps_algorithm_t algorithm;
+    /* the threads of the parallel search, 0 uses one per processor */
+    unsigned threads;
+    snps_stats_f callback;
+    /* stop after about that many states, 0 means no limit */
+    unsigned long long states;
+    /* stop once snps_clock passes this time, 0 means no limit */
+    double deadline;
+    /* stop as soon as it's set to non zero, also by another thread */
+    int *cancel;
+    /* receives the routes of the anytime search */
+    snps_improved_f improved;
+    void *data;
+    /* reuse the memory of a solver context, NULL for a temporary one */
+    snps_solver_t *solver;
+} snps_options_t;
+
+typedef struct {
+    snps_route_t *route;
+    snps_stats_t stats;
+    snps_status_t status;
+} snps_result_t;
+
+/* the number of boards at every distance to a goal board, the largest
+   distance is depths - 1, some of the boards at this distance are kept */
+typedef struct {
+    unsigned long long *counts;
+    unsigned depths;
+    unsigned char **deepest;
+    unsigned deepest_count;
+    unsigned size;
+} snps_distances_t;
+
+/* the vector instructions the solvers may use for operations on whole
+   boards */
+typedef enum {
+    SNPS_SIMD_SCALAR,
+    SNPS_SIMD_SSE4,
+    SNPS_SIMD_AVX2,
+} snps_simd_t;
+
+/* the most cells of a board, whose tiles and cells fit into a byte */
+#define SNPS_SIZE_MAX 255
+
 /* coordinate conversion */
-#define TRANSLATE_2D_TO_1D(row, column, rows) ((row) * (rows) + (column))
+#define TRANSLATE_2D_TO_1D(row, column, columns) ((row) * (columns) + (column))
 #define TRANSLATE_1D_TO_ROW(position, columns) ((position) / (columns))
 #define TRANSLATE_1D_TO_COLUMN(position, columns) ((position) % (columns))
 
-/* allocate a new game which may be solved */
+/* allocate a new game which may be solved, NULL if the board is empty or
+   has more than SNPS_SIZE_MAX cells */
 extern snps_game_t *snps_game_new(unsigned rows, unsigned columns,
     const unsigned char *from, const unsigned char *to);
 /* free a game instance */
 extern void snps_game_free(snps_game_t *game);
+/* check whether the goal board can be reached from the start board, which
+   is false as well for boards not containing every tile exactly once, the
+   solvers return NULL right away for those games */
+extern int snps_game_solvable(snps_game_t *game);
+/* the estimated number of moves from the start board to the goal board by
+   the heuristic the solvers use, a lower bound of the optimal route */
+extern unsigned snps_game_estimate(snps_game_t *game);
+/* let the solvers walk along the exact distances of a table instead of
+   searching, which has to be built for the same goal board, NULL switches
+   back to searching, the table is not owned by the game */
+extern void snps_game_set_table(snps_game_t *game, snps_table_t *table);
+/* let the solvers use a pattern database as their heuristic, which has to be
+   built for the same goal board, NULL switches back to the manhattan
+   distance, the database is not owned by the game */
+extern void snps_game_set_pdb(snps_game_t *game, snps_pdb_t *pdb);
+/* add the linear conflicts of tiles in their goal rows and columns to the
+   manhattan distance, it has no effect with a pattern database */
+extern void snps_game_set_linear_conflict(snps_game_t *game, int enabled);
+/* limit the bytes used by the states of the searches keeping them, 0 means
+   no limit, once it's reached the optimal searches continue with an
+   iterative deepening search, the fast search with a weighted one from its
+   best open state and the anytime search before its first route with a
+   weighted one from the start board */
+extern void snps_game_set_memory_limit(snps_game_t *game, size_t bytes);
+/* let the searches, except for the bidirectional and anytime ones, stop at
+   boards within depth moves of the goal board and complete the route from a
+   table of these boards, which is built by a breadth first search from the
+   goal board and shared by all games with the same goal board and depth,
+   its size grows about twofold with every move of depth, 0 turns it off */
+extern void snps_game_set_perimeter(snps_game_t *game, unsigned depth);
+/* choose the representations of the routes of a game as a combination of
+   snps_route_format_t, only the moves are filled in by default, the boards
+   of a route may be rebuilt from its moves at any time */
+extern void snps_game_set_route_format(snps_game_t *game, unsigned format);
+
+/* a source of solvable games of a shape and goal board, NULL selects the
+   ordered board with the blank last, the same seed yields the same games
+   on every platform, NULL if the shape has more than SNPS_SIZE_MAX cells
+   or the goal board doesn't hold every tile exactly once */
+extern snps_generator_t *snps_generator_new(unsigned rows, unsigned columns,
+    const unsigned char *goal, unsigned seed);
+/* free a generator */
+extern void snps_generator_free(snps_generator_t *generator);
+/* a game whose start board is reached by a random walk of the blank from
+   the goal board, which never undoes its last move, so the optimal route
+   is at most that many moves long */
+extern snps_game_t *snps_generator_walk(snps_generator_t *generator,
+    unsigned moves);
+/* a game whose start board is a uniformly random permutation of the tiles
+   among those which can reach the goal board */
+extern snps_game_t *snps_generator_permutation(snps_generator_t *generator);
+
+/* parse a board of size comma separated tiles or of a hex digit per tile,
+   returns 0 on success */
+extern int snps_board_parse(const char *text, unsigned size,
+    unsigned char *board);
+/* write a board as comma separated tiles, text holds 4 * size bytes */
+extern void snps_board_format(const unsigned char *board, unsigned size,
+    char *text);
+
+/* build an additive pattern database for the goal board of a game, the
+   partition maps every tile to the index of its pattern, NULL splits the
+   tiles into patterns of up to six tiles, at most eight tiles per pattern */
+extern snps_pdb_t *snps_pdb_build(snps_game_t *game,
+    const unsigned char *partition);
+/* write a pattern database to a file, returns 0 on success */
+extern int snps_pdb_save(snps_pdb_t *pdb, const char *filename);
+/* map a pattern database file read-only into memory, returns NULL if the file
+   is unusable or doesn't match the goal board of the game */
+extern snps_pdb_t *snps_pdb_load(snps_game_t *game, const char *filename);
+/* free or unmap a pattern database */
+extern void snps_pdb_free(snps_pdb_t *pdb);
+
+/* build a table of the exact distances of all boards to the goal board of
+   a game with a breadth first search, it takes half a byte per permutation
+   of the tiles, about 180 KB for 9 cells and 240 MB for 12 cells, boards
+   of more than 12 cells yield NULL */
+extern snps_table_t *snps_table_build(snps_game_t *game);
+/* write a table of exact distances to a file, returns 0 on success */
+extern int snps_table_save(snps_table_t *table, const char *filename);
+/* map a table file read-only into memory, returns NULL if the file is
+   unusable or doesn't match the goal board of the game */
+extern snps_table_t *snps_table_load(snps_game_t *game,
+    const char *filename);
+/* free or unmap a table of exact distances */
+extern void snps_table_free(snps_table_t *table);
 
 /* a simple breadth first solving algorithm which utilises pruning to find
    the optimal route */
@@ -61,9 +296,100 @@ extern snps_route_t *snps_solve_optimal(snps_game_t *game, snps_stats_f stats);
 /* a faster approach using a heuristic and a sorted list to find a route,
    don't have to be the optimal route! */
 extern snps_route_t *snps_solve_fast(snps_game_t *game, snps_stats_f stats);
+/* an iterative deepening A* search which finds the optimal route while only
+   using memory linear in the length of the route */
+extern snps_route_t *snps_solve_ida(snps_game_t *game, snps_stats_f stats);
+/* an optimal bidirectional search from both boards, which meets in the
+   middle of the route and explores far fewer states than a breadth first
+   search */
+extern snps_route_t *snps_solve_bidirectional(snps_game_t *game,
+    snps_stats_f stats);
+/* the iterative deepening A* search running each iteration on a number of
+   threads, 0 uses one per processor, it finds the same route as
+   snps_solve_ida */
+extern snps_route_t *snps_solve_ida_parallel(snps_game_t *game,
+    unsigned threads, snps_stats_t *stats);
+/* the search of snps_solve_fast running on a number of threads, 0 uses one
+   per processor, every board is owned by a thread chosen by its hash, which
+   keeps its own states and receives those created by the other threads, it
+   may find another route than snps_solve_fast */
+extern snps_route_t *snps_solve_fast_parallel(snps_game_t *game,
+    unsigned threads, snps_stats_t *stats);
+/* solve boards larger than 3x3 by placing the tiles of the outer row or
+   column one by one with small searches until 3x3 cells are left, which
+   are solved exactly, it takes milliseconds and little memory even for
+   the largest boards, but the route is far from optimal */
+extern snps_route_t *snps_solve_decompose(snps_game_t *game,
+    snps_stats_t *stats);
+/* an anytime search which finds a first route quickly and keeps improving
+   it until it's optimal or the given number of seconds passed, 0 means no
+   limit, every better route is passed to improved, which must not free it,
+   the last one is returned, NULL if time ran out before the first one */
+extern snps_route_t *snps_solve_anytime(snps_game_t *game, double seconds,
+    snps_improved_f improved, void *data, snps_stats_t *stats);
+/* solve a game using one of the algorithms above, the statistics of the
+   search are stored in stats if it's not NULL */
+extern snps_route_t *snps_solve(snps_game_t *game,
+    snps_algorithm_t algorithm, snps_stats_t *stats);
+/* the seconds of a monotonic clock, the time the deadline of the options
+   refers to */
+extern double snps_clock(void);
+/* solve a game within the budget of the options, the route and the
+   statistics are stored in result, returns the status stored there too */
+extern snps_status_t snps_solve_with(snps_game_t *game,
+    const snps_options_t *options, snps_result_t *result);
+/* solve many games concurrently using a number of threads, 0 selects one per
+   processor, the results are stored in the order of the games */
+extern void snps_solve_batch(snps_game_t **games, unsigned count,
+    snps_algorithm_t algorithm, unsigned threads, snps_result_t *results);
+
+/* count the boards at every distance to the goal board of a game with a
+   breadth first search keeping its layers in files of sorted boards within
+   a directory, which also serve as table of the exact distances, memory
+   bounds the bytes used to sort the boards, 0 selects a default, up to
+   deepest boards of the largest distance are returned, an interrupted
+   enumeration continues at its last complete layer, boards of more than
+   16 cells and I/O errors yield NULL */
+extern snps_distances_t *snps_enumerate(snps_game_t *game,
+    const char *directory, size_t memory, unsigned deepest);
+/* free the distances of an enumeration */
+extern void snps_distances_free(snps_distances_t *distances);
+
+/* the vector instructions used by the solvers, the best ones the processor
+   supports unless limited */
+extern snps_simd_t snps_simd_level(void);
+/* let the solvers use at most the given vector instructions, for example
+   SNPS_SIMD_SCALAR to compare the results against the plain code, returns
+   the instructions used from now on, it must not be called while a search
+   is running */
+extern snps_simd_t snps_simd_limit(snps_simd_t simd);
+
+/* allocate a solver context, which keeps the memory of its searches for the
+   next one instead of allocating and freeing every state, a context may only
+   be used by one thread at a time */
+extern snps_solver_t *snps_solver_new(void);
+/* free a solver context */
+extern void snps_solver_free(snps_solver_t *solver);
+/* solve a game like snps_solve, but reusing the memory of the context */
+extern snps_route_t *snps_solver_solve(snps_solver_t *solver,
+    snps_game_t *game, snps_algorithm_t algorithm, snps_stats_t *stats);
 
 /* free a route instance */
 extern void snps_route_free(snps_route_t *route);
+/* the move of the blank leading from the board at index to the next one,
+   one of L, R, U and D */
+extern char snps_route_move(const snps_route_t *route, unsigned index);
+/* write the moves of a route as string of length - 1 characters */
+extern void snps_route_write_moves(const snps_route_t *route, char *moves);
+/* rebuild the board at index of a route by replaying its moves */
+extern void snps_route_board(const snps_route_t *route, unsigned index,
+    unsigned char *board);
+/* start walking along a route at its start board, which is copied into
+   board, a buffer of size bytes */
+extern void snps_route_iter_init(snps_route_iter_t *iter,
+    const snps_route_t *route, unsigned char *board);
+/* advance to the next board of a route, returns 0 at its last board */
+extern int snps_route_iter_next(snps_route_iter_t *iter);
 
 #endif
 
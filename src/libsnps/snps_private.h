@@ -0,0 +1,563 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef SNPS_PRIVATE_H
+#define SNPS_PRIVATE_H
+
+#include "snps.h"
+
+#include <glib.h>
+
+/* an additive pattern database, the tables either live on the heap or
+   inside a read-only mapping of a database file */
+struct snps_pdb {
+    unsigned rows;
+    unsigned columns;
+    unsigned size;
+    unsigned count;
+    unsigned char *goal;
+    unsigned char *partition;
+    unsigned char *tiles;
+    unsigned *lengths;
+    unsigned *offsets;
+    unsigned char **tables;
+    void *map;
+    gsize map_length;
+};
+
+/* marks a missing item wherever items are referenced by 32 bit indexes */
+#define SNPS_NONE G_MAXUINT32
+
+/* items of a fixed size allocated from chunks which are kept when the pool
+   is reset, so the memory is reused by the next search, the items never
+   move and are addressed by a 32 bit index */
+#define SNPS_POOL_CHUNK_BITS 12
+
+/* instrumentation of the searches, which is only compiled in with
+   SNPS_PROFILE defined, a clock started in a block is stopped by adding the
+   seconds since to a counter */
+#ifdef SNPS_PROFILE
+#define SNPS_PROFILE_ADD(profile, counter, value) \
+    ((profile)->counter += (value))
+#define SNPS_PROFILE_PEAK(profile, counter, value) \
+    ((profile)->counter = MAX((profile)->counter, (value)))
+#define SNPS_PROFILE_START(clock) gint64 clock = g_get_monotonic_time()
+#define SNPS_PROFILE_STOP(profile, counter, clock) \
+    ((profile)->counter += (g_get_monotonic_time() - (clock)) / 1000000.0)
+#else
+#define SNPS_PROFILE_ADD(profile, counter, value) ((void) 0)
+#define SNPS_PROFILE_PEAK(profile, counter, value) ((void) 0)
+#define SNPS_PROFILE_START(clock) ((void) 0)
+#define SNPS_PROFILE_STOP(profile, counter, clock) ((void) 0)
+#endif
+
+typedef struct {
+    char **chunks;
+    unsigned chunk_count;
+    gsize chunk_item_size;
+    gsize item_size;
+    guint32 count;
+} snps_pool_t;
+
+/* boards packed into 64 bit words, 4 bits per tile for up to 16 cells and
+   otherwise as few bits as possible without a tile spanning two words */
+typedef struct {
+    unsigned size;
+    unsigned words;
+    unsigned bits;
+    unsigned tiles;
+} snps_packing_t;
+
+/* an open addressing hash set of pool items containing a packed board at a
+   fixed offset, single word boards are kept within the slots to avoid
+   touching the items on lookups, otherwise the slots hold the full hash,
+   slots of an older generation are empty so a reset doesn't touch them */
+typedef struct {
+    guint64 tag;
+    guint32 item;
+    guint32 generation;
+} snps_slot_t;
+
+typedef struct {
+    snps_slot_t *slots;
+    gsize mask;
+    gsize count;
+    unsigned words;
+    snps_pool_t *pool;
+    gsize offset;
+    guint32 generation;
+    /* the counters of the search using the set */
+    snps_profile_t *profile;
+} snps_set_t;
+
+/* a two level bucket queue of item indexes ordered by f and then by h, each
+   bucket is a stack so the most recently pushed item is returned first,
+   levels of an older generation are emptied once they are used again */
+typedef struct {
+    guint32 *items;
+    unsigned length;
+    unsigned capacity;
+} snps_bucket_t;
+
+typedef struct {
+    snps_bucket_t *buckets;
+    unsigned capacity;
+    unsigned count;
+    unsigned min;
+    unsigned generation;
+} snps_level_t;
+
+typedef struct {
+    snps_level_t *levels;
+    unsigned capacity;
+    gsize count;
+    unsigned min;
+    unsigned generation;
+    /* the counters of the search using the queue */
+    snps_profile_t *profile;
+} snps_queue_t;
+
+/* the limits of a search shared by all of its threads, the status turns
+   from solved into the reason once a search has to stop, the deadline is a
+   time of the monotonic clock and 0 means no limit like for the number of
+   states */
+#define SNPS_BUDGET_INTERVAL 256
+
+typedef struct {
+    guint64 states;
+    gint64 deadline;
+    int *cancel;
+    gint intervals;
+    gint status;
+} snps_budget_t;
+
+/* the exact distances of all boards to a goal board, kept as distance
+   modulo 16 in half a byte per board indexed by the rank of the board,
+   either on the heap or inside a read-only mapping of a table file, the
+   boards which can't reach the goal board hold 0 */
+struct snps_table {
+    unsigned rows;
+    unsigned columns;
+    unsigned size;
+    /* the largest distance of any board */
+    unsigned depth;
+    unsigned char *goal;
+    guint64 count;
+    unsigned char *distances;
+    void *map;
+    gsize map_length;
+};
+
+/* the boards within a number of moves of a goal board, shared by all games
+   with this goal board */
+struct snps_perimeter {
+    unsigned rows;
+    unsigned columns;
+    unsigned depth;
+    unsigned char *goal;
+    snps_packing_t packing;
+    snps_pool_t *pool;
+    snps_set_t *set;
+    snps_profile_t profile;
+    int references;
+};
+
+/* the memory of all searches run by a solver, one pool, set and queue for
+   each side of a bidirectional search */
+struct snps_solver {
+    snps_pool_t *pools[2];
+    snps_set_t *sets[2];
+    snps_queue_t *queues[2];
+};
+
+/* allocate an empty pool */
+extern snps_pool_t *snps_pool_new(void);
+/* free a pool including all items */
+extern void snps_pool_free(snps_pool_t *pool);
+/* forget all items and use the given item size from now on, the chunks are
+   only released if the items don't fit into them anymore */
+extern void snps_pool_reset(snps_pool_t *pool, gsize item_size);
+/* allocate a new item and return its index */
+extern guint32 snps_pool_alloc(snps_pool_t *pool);
+
+/* the item at an index of a pool */
+static inline gpointer snps_pool_get(const snps_pool_t *pool, guint32 index)
+{
+    return pool->chunks[index >> SNPS_POOL_CHUNK_BITS] +
+        (index & ((1u << SNPS_POOL_CHUNK_BITS) - 1)) * pool->item_size;
+}
+
+/* calculate the layout of packed boards */
+extern void snps_packing_init(snps_packing_t *packing, unsigned size);
+/* pack a board into a key */
+extern void snps_key_pack(const snps_packing_t *packing, guint64 *key,
+    const unsigned char *board);
+/* restore a board from a key */
+extern void snps_key_unpack(const snps_packing_t *packing,
+    const guint64 *key, unsigned char *board);
+
+/* allocate an empty set of items of a pool, the keys are found at the
+   given offset of the items */
+extern snps_set_t *snps_set_new(snps_pool_t *pool, gsize offset);
+/* free a set, but not the items */
+extern void snps_set_free(snps_set_t *set);
+/* remove all items and use keys of the given number of words from now on */
+extern void snps_set_reset(snps_set_t *set, unsigned words);
+/* find the slot of a key, it's empty if the key is not yet contained */
+extern snps_slot_t *snps_set_slot(snps_set_t *set, const guint64 *key);
+/* put a new item into an empty slot returned by snps_set_slot */
+extern void snps_set_fill(snps_set_t *set, snps_slot_t *slot,
+    const guint64 *key, guint32 item);
+/* the item containing a key or SNPS_NONE, which doesn't change the set so
+   many threads may look up items at once */
+extern guint32 snps_set_find(snps_set_t *set, const guint64 *key);
+
+/* the item of a slot returned by snps_set_slot, SNPS_NONE if it's empty */
+static inline guint32 snps_set_item(const snps_set_t *set,
+    const snps_slot_t *slot)
+{
+    return slot->generation == set->generation ? slot->item : SNPS_NONE;
+}
+
+/* allocate an empty queue */
+extern snps_queue_t *snps_queue_new(void);
+/* free a queue, but not the items */
+extern void snps_queue_free(snps_queue_t *queue);
+/* remove all items while keeping the memory */
+extern void snps_queue_reset(snps_queue_t *queue);
+/* add an item with the given priorities */
+extern void snps_queue_push(snps_queue_t *queue, unsigned f, unsigned h,
+    guint32 item);
+/* the item with the lowest f and h, SNPS_NONE if the queue is empty,
+   afterwards the lowest f is found in min */
+extern guint32 snps_queue_peek(snps_queue_t *queue);
+/* remove the item with the lowest f and h, SNPS_NONE if the queue is
+   empty */
+extern guint32 snps_queue_pop(snps_queue_t *queue);
+
+/* mix all words of a packed board into a well distributed hash */
+static inline guint64 snps_key_hash(const guint64 *key, unsigned words)
+{
+    guint64 hash = 0;
+
+    for (int i = 0; i < words; ++i) {
+        hash ^= key[i];
+        hash ^= hash >> 33;
+        hash *= G_GUINT64_CONSTANT(0xff51afd7ed558ccd);
+        hash ^= hash >> 33;
+        hash *= G_GUINT64_CONSTANT(0xc4ceb9fe1a85ec53);
+        hash ^= hash >> 33;
+    }
+
+    return hash;
+}
+
+/* the tile at a cell of a packed board */
+static inline unsigned snps_key_get(const snps_packing_t *packing,
+    const guint64 *key, unsigned i)
+{
+    if (packing->words == 1)
+        return (key[0] >> (i * 4)) & 0xf;
+
+    return (key[i / packing->tiles] >> (i % packing->tiles * packing->bits))
+        & ((1u << packing->bits) - 1);
+}
+
+/* slide the tile at cell q into the blank at cell p */
+static inline void snps_key_move(const snps_packing_t *packing, guint64 *key,
+    unsigned p, unsigned q)
+{
+    guint64 tile = snps_key_get(packing, key, q);
+
+    if (packing->words == 1) {
+        key[0] = (key[0] & ~((guint64) 0xf << (q * 4))) | tile << (p * 4);
+        return;
+    }
+
+    unsigned shift = q % packing->tiles * packing->bits;
+    key[q / packing->tiles] &= ~(((G_GUINT64_CONSTANT(1) << packing->bits)
+        - 1) << shift);
+    key[p / packing->tiles] |= tile << (p % packing->tiles * packing->bits);
+}
+
+/* the board sizes with search code specialised for them, snps_game_new
+   picks the kernel of a game and falls back to the generic one */
+typedef enum {
+    SNPS_KERNEL_GENERIC,
+    SNPS_KERNEL_3X3,
+    SNPS_KERNEL_4X4,
+    SNPS_KERNEL_5X5,
+} snps_kernel_t;
+
+/* the cells next to every cell of the specialised board sizes in the order
+   left, right, up and down, -1 marks cells outside of the board */
+extern const signed char snps_neighbours_3x3[9][4];
+extern const signed char snps_neighbours_4x4[16][4];
+extern const signed char snps_neighbours_5x5[25][4];
+/* the table of every kernel, NULL for the generic one */
+extern const signed char (*const snps_kernel_neighbours[])[4];
+
+/* the kernel specialised for a board size */
+extern snps_kernel_t snps_kernel_select(unsigned rows, unsigned columns);
+
+/* the cells next to p in the order left, right, up and down, -1 marks
+   cells outside of the board */
+static inline void snps_neighbours(const snps_game_t *game, int p,
+    int *cells)
+{
+    const signed char (*neighbours)[4] = snps_kernel_neighbours[game->kernel];
+
+    if (neighbours != NULL) {
+        for (int i = 0; i < 4; ++i)
+            cells[i] = neighbours[p][i];
+        return;
+    }
+
+    int row = TRANSLATE_1D_TO_ROW(p, game->columns);
+    int column = TRANSLATE_1D_TO_COLUMN(p, game->columns);
+
+    cells[0] = column > 0 ? p - 1 : -1;
+    cells[1] = column < game->columns - 1 ? p + 1 : -1;
+    cells[2] = row > 0 ? p - game->columns : -1;
+    cells[3] = row < game->rows - 1 ? p + game->columns : -1;
+}
+
+/* operations on whole boards, which use vector instructions if the
+   processor supports them, boards of up to 16 cells are packed into single
+   words, the board buffers of those hold 16 bytes */
+typedef struct {
+    void (*unpack)(guint64 key, unsigned char *board);
+    guint64 (*pack)(const unsigned char *board);
+    /* the manhattan distance of a board to the goal of a game */
+    unsigned (*manhattan)(const snps_game_t *game,
+        const unsigned char *board);
+} snps_simd_ops_t;
+
+/* the operations chosen for the processor by snps_simd_init */
+extern const snps_simd_ops_t *snps_simd_ops;
+
+/* detect the vector instructions of the processor once */
+extern void snps_simd_init(void);
+
+/* rank a variation without repetition of count values below size, which
+   is the lehmer code of a permutation if count is size, the values are
+   cells of tiles or tiles of cells */
+static inline guint64 snps_rank(unsigned size, unsigned count,
+    const unsigned char *values)
+{
+    guint64 used = 0, rank = 0;
+
+    for (int i = 0; i < count; ++i) {
+        guint64 below = used & ((G_GUINT64_CONSTANT(1) << values[i]) - 1);
+        rank = rank * (size - i) + values[i] - __builtin_popcountll(below);
+        used |= G_GUINT64_CONSTANT(1) << values[i];
+    }
+
+    return rank;
+}
+
+/* inverse of snps_rank */
+static inline void snps_unrank(unsigned size, unsigned count, guint64 rank,
+    unsigned char *values)
+{
+    unsigned char digits[count];
+    guint64 used = 0;
+
+    for (int i = count - 1; i >= 0; --i) {
+        digits[i] = rank % (size - i);
+        rank /= size - i;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        unsigned p = 0;
+        for (unsigned skip = digits[i]; ; ++p)
+            if ((used & (G_GUINT64_CONSTANT(1) << p)) == 0 && skip-- == 0)
+                break;
+        values[i] = p;
+        used |= G_GUINT64_CONSTANT(1) << p;
+    }
+}
+
+/* walk along the exact distances of the table of a game from its start
+   board to its goal board, NULL if the table doesn't match the game */
+extern snps_route_t *snps_table_walk(snps_table_t *table, snps_game_t *game,
+    snps_stats_t *stats);
+
+/* get the perimeter of a goal board of a game, building it unless another
+   game uses it already, every perimeter acquired has to be released */
+extern snps_perimeter_t *snps_perimeter_acquire(snps_game_t *game,
+    unsigned depth);
+extern void snps_perimeter_release(snps_perimeter_t *perimeter);
+/* the distance of a board to the goal board, G_MAXUINT if it's outside of
+   the perimeter */
+extern unsigned snps_perimeter_distance(snps_perimeter_t *perimeter,
+    const guint64 *key);
+/* write the moves of the blank from a board of the perimeter of a game to
+   the goal board, returns their number */
+extern unsigned snps_perimeter_moves(snps_game_t *game,
+    const guint64 *key, char *moves);
+
+/* add the counters of another profile, keeping the larger peaks */
+extern void snps_profile_add(snps_profile_t *profile,
+    const snps_profile_t *other);
+
+/* count another interval of states and check all limits of a budget,
+   returns TRUE if the search has to stop */
+extern gboolean snps_budget_check(snps_budget_t *budget);
+
+/* whether a search which looked at the given number of states has to stop,
+   the limits are only checked every few states */
+static inline gboolean snps_budget_stop(snps_budget_t *budget,
+    unsigned compared)
+{
+    return compared % SNPS_BUDGET_INTERVAL == 0 && snps_budget_check(budget);
+}
+
+/* allocate a route of count moves from a start board, the moves are set
+   one by one and the representations chosen by the game are added once
+   they are complete */
+extern snps_route_t *snps_route_alloc(snps_game_t *game,
+    const unsigned char *start, unsigned count);
+extern void snps_route_set_move(snps_route_t *route, unsigned index,
+    char move);
+extern void snps_route_complete(snps_game_t *game, snps_route_t *route);
+/* the move of the blank from one cell to a neighbouring one */
+extern char snps_route_direction(snps_game_t *game, unsigned from,
+    unsigned to);
+/* create a new route by replaying the moves of the blank on the start
+   board */
+extern snps_route_t *snps_route_new_moves(snps_game_t *game,
+    const char *moves, unsigned count);
+
+/* iterative deepening A* searches, the parallel one uses the given number of
+   threads or one per processor for 0 */
+extern snps_route_t *snps_run_ida(snps_game_t *game, snps_stats_f callback,
+    snps_budget_t *budget, snps_stats_t *stats);
+extern snps_route_t *snps_run_ida_parallel(snps_game_t *game,
+    unsigned threads, snps_budget_t *budget, snps_stats_t *stats);
+/* a best first search weighting the heuristic twice like the fast one,
+   whose states are owned by one of the given number of threads chosen by
+   their hash, 0 uses one per processor */
+extern snps_route_t *snps_run_fast_parallel(snps_game_t *game,
+    unsigned threads, snps_budget_t *budget, snps_stats_t *stats);
+/* solve a game line by line from the outside, see snps_solve_decompose */
+extern snps_route_t *snps_run_decompose(snps_game_t *game,
+    snps_budget_t *budget, snps_stats_t *stats);
+/* an iterative deepening A* search continuing after some moves of the
+   blank, which counts the heuristic weight times and starts with at least
+   the given threshold, the statistics in stats are counted on */
+extern snps_route_t *snps_run_ida_from(snps_game_t *game, const char *moves,
+    unsigned count, unsigned weight, unsigned bound, snps_stats_f callback,
+    snps_budget_t *budget, snps_stats_t *stats);
+
+/* create and free the lookup tables of a game */
+extern void snps_heuristic_init(snps_game_t *game);
+extern void snps_heuristic_clear(snps_game_t *game);
+/* estimated distance of a board to the goal of a game */
+extern unsigned snps_heuristic(snps_game_t *game, const unsigned char *board);
+/* change of the linear conflicts when sliding the tile at cell q into the
+   blank at cell p, the board is restored before returning */
+extern int snps_conflicts_move(snps_game_t *game, unsigned char *board,
+    unsigned p, unsigned q);
+
+/* all tiles of a line not within the longest increasing subsequence of
+   their goals have to leave the line and come back, lengths holds count
+   bytes */
+static inline unsigned snps_conflicts_line(const unsigned char *goals,
+    unsigned char *lengths, unsigned count)
+{
+    unsigned longest = 0;
+
+    for (int i = 0; i < count; ++i) {
+        lengths[i] = 1;
+        for (int j = 0; j < i; ++j)
+            if (goals[j] < goals[i] && lengths[j] >= lengths[i])
+                lengths[i] = lengths[j] + 1;
+        if (lengths[i] > longest)
+            longest = lengths[i];
+    }
+
+    return 2 * (count - longest);
+}
+
+/* additional moves of the tiles in their goal row, the size of the board is
+   passed on its own so the kernels can fix it at compile time */
+static inline unsigned snps_conflicts_row(const snps_game_t *game,
+    const unsigned char *board, unsigned row, unsigned columns)
+{
+    unsigned char goals[columns], lengths[columns];
+    unsigned count = 0;
+
+    for (int column = 0; column < columns; ++column) {
+        unsigned char tile = board[row * columns + column];
+        if (tile != 0 && game->goal_rows[tile] == row)
+            goals[count++] = game->goal_columns[tile];
+    }
+
+    return snps_conflicts_line(goals, lengths, count);
+}
+
+/* additional moves of the tiles in their goal column */
+static inline unsigned snps_conflicts_column(const snps_game_t *game,
+    const unsigned char *board, unsigned column, unsigned rows,
+    unsigned columns)
+{
+    unsigned char goals[rows], lengths[rows];
+    unsigned count = 0;
+
+    for (int row = 0; row < rows; ++row) {
+        unsigned char tile = board[row * columns + column];
+        if (tile != 0 && game->goal_columns[tile] == column)
+            goals[count++] = game->goal_rows[tile];
+    }
+
+    return snps_conflicts_line(goals, lengths, count);
+}
+
+/* estimated distance after sliding the tile at cell q into the blank at
+   cell p given the estimate h of the board, which doesn't use a pattern
+   database */
+static inline unsigned snps_heuristic_move(snps_game_t *game,
+    unsigned char *board, unsigned h, unsigned p, unsigned q)
+{
+    const unsigned char *distances = game->distances + board[q] * game->size;
+    h = h + distances[p] - distances[q];
+
+    if (game->linear_conflict)
+        h += snps_conflicts_move(game, board, p, q);
+
+    return h;
+}
+
+/* estimated distance of a board to the goal of the pattern database */
+extern unsigned snps_pdb_heuristic(const snps_pdb_t *pdb,
+    const unsigned char *board);
+/* distance of a single pattern, positions maps every tile to its cell */
+extern unsigned snps_pdb_pattern(const snps_pdb_t *pdb, unsigned pattern,
+    const unsigned char *positions);
+
+#endif
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,335 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "snps_private.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+
+#define SNPS_TABLE_MAGIC "SNPSTBL"
+#define SNPS_TABLE_VERSION 1
+#define SNPS_TABLE_MAX_SIZE 12
+
+/* data type, the file starts with this header followed by the goal board,
+   padding up to 8 bytes and the distances, all stored in native byte
+   order */
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 rows;
+    guint32 columns;
+    guint32 depth;
+} snps_table_header_t;
+
+/* prototypes */
+static snps_table_t *snps_table_new(unsigned rows, unsigned columns,
+    const unsigned char *goal);
+static gsize snps_table_offset(snps_table_t *table);
+static unsigned snps_table_get(const snps_table_t *table, guint64 rank);
+static void snps_table_set(snps_table_t *table, guint64 rank,
+    unsigned distance);
+
+extern snps_table_t *snps_table_build(snps_game_t *game)
+{
+    unsigned size = game->size;
+
+    if (size > SNPS_TABLE_MAX_SIZE || !snps_game_solvable(game))
+        return NULL;
+
+    snps_table_t *table = snps_table_new(game->rows, game->columns,
+        game->to);
+    table->distances = g_malloc0((table->count + 1) / 2);
+
+    /* the boards seen so far, those of the current and of the next layer
+       are bits indexed by their rank */
+    gsize words = (table->count + 63) / 64;
+    guint64 *seen = g_new0(guint64, words);
+    guint64 *layer = g_new0(guint64, words);
+    guint64 *next = g_new0(guint64, words);
+
+    guint64 goal = snps_rank(size, size, game->to);
+    seen[goal / 64] |= G_GUINT64_CONSTANT(1) << (goal % 64);
+    layer[goal / 64] |= G_GUINT64_CONSTANT(1) << (goal % 64);
+    snps_table_set(table, goal, 0);
+
+    for (unsigned depth = 0; ; ++depth) {
+        gboolean found = FALSE;
+
+        for (gsize i = 0; i < words; ++i) {
+            for (guint64 bits = layer[i]; bits != 0; bits &= bits - 1) {
+                guint64 rank = i * 64 + __builtin_ctzll(bits);
+                unsigned char board[size];
+                snps_unrank(size, size, rank, board);
+
+                int p = 0, cells[4];
+                while (board[p] != 0)
+                    ++p;
+                snps_neighbours(game, p, cells);
+
+                for (int j = 0; j < 4; ++j) {
+                    if (cells[j] < 0)
+                        continue;
+
+                    board[p] = board[cells[j]];
+                    board[cells[j]] = 0;
+
+                    guint64 child = snps_rank(size, size, board);
+                    guint64 bit = G_GUINT64_CONSTANT(1) << (child % 64);
+                    if ((seen[child / 64] & bit) == 0) {
+                        seen[child / 64] |= bit;
+                        next[child / 64] |= bit;
+                        snps_table_set(table, child, depth + 1);
+                        found = TRUE;
+                    }
+
+                    board[cells[j]] = board[p];
+                    board[p] = 0;
+                }
+            }
+        }
+
+        if (!found) {
+            table->depth = depth;
+            break;
+        }
+
+        guint64 *swap = layer;
+        layer = next;
+        next = swap;
+        memset(next, 0, words * sizeof(guint64));
+    }
+
+    g_free(next);
+    g_free(layer);
+    g_free(seen);
+
+    return table;
+}
+
+extern int snps_table_save(snps_table_t *table, const char *filename)
+{
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+        return -1;
+
+    snps_table_header_t header = {
+        .magic = SNPS_TABLE_MAGIC,
+        .version = SNPS_TABLE_VERSION,
+        .rows = table->rows,
+        .columns = table->columns,
+        .depth = table->depth,
+    };
+
+    char padding[8] = {0};
+    gsize offset = snps_table_offset(table);
+    gsize written = sizeof(header) + table->size;
+    int failed = 0;
+
+    failed |= fwrite(&header, sizeof(header), 1, file) != 1;
+    failed |= fwrite(table->goal, table->size, 1, file) != 1;
+    if (offset > written)
+        failed |= fwrite(padding, offset - written, 1, file) != 1;
+    failed |= fwrite(table->distances, (table->count + 1) / 2, 1,
+        file) != 1;
+
+    failed |= fclose(file) != 0;
+
+    return failed ? -1 : 0;
+}
+
+extern snps_table_t *snps_table_load(snps_game_t *game, const char *filename)
+{
+    if (game->size > SNPS_TABLE_MAX_SIZE)
+        return NULL;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) (
+        sizeof(snps_table_header_t) + game->size)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return NULL;
+
+    snps_table_header_t *header = map;
+    unsigned char *goal = (unsigned char *) map + sizeof(*header);
+    snps_table_t *table = NULL;
+
+    if (memcmp(header->magic, SNPS_TABLE_MAGIC, sizeof(header->magic)) == 0
+        && header->version == SNPS_TABLE_VERSION &&
+        header->rows == game->rows && header->columns == game->columns &&
+        memcmp(goal, game->to, game->size) == 0)
+        table = snps_table_new(game->rows, game->columns, goal);
+
+    if (table == NULL || snps_table_offset(table) + (table->count + 1) / 2
+        != (gsize) st.st_size) {
+        if (table != NULL)
+            snps_table_free(table);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    table->depth = header->depth;
+    table->distances = (unsigned char *) map + snps_table_offset(table);
+    table->map = map;
+    table->map_length = st.st_size;
+
+    return table;
+}
+
+extern void snps_table_free(snps_table_t *table)
+{
+    if (table->map != NULL)
+        munmap(table->map, table->map_length);
+    else
+        g_free(table->distances);
+
+    g_free(table->goal);
+    g_slice_free(snps_table_t, table);
+}
+
+extern snps_route_t *snps_table_walk(snps_table_t *table, snps_game_t *game,
+    snps_stats_t *stats)
+{
+    static const char directions[] = "LRUD";
+
+    unsigned size = game->size;
+
+    if (table->rows != game->rows || table->columns != game->columns ||
+        memcmp(table->goal, game->to, size) != 0)
+        return NULL;
+
+    unsigned char board[size];
+    memcpy(board, game->from, size);
+
+    int p = 0;
+    while (board[p] != 0)
+        ++p;
+
+    /* the neighbours of a board are one move closer or further away, so the
+       distance modulo 16 tells them apart */
+    guint64 rank = snps_rank(size, size, board);
+    unsigned distance = snps_table_get(table, rank);
+    char moves[table->depth + 1];
+    unsigned length = 0, compared = 1;
+
+    while (memcmp(board, game->to, size) != 0) {
+        unsigned closer = (distance + 15) % 16;
+        int cells[4], i;
+
+        if (length == table->depth)
+            return NULL;
+
+        snps_neighbours(game, p, cells);
+
+        for (i = 0; i < 4; ++i) {
+            if (cells[i] < 0)
+                continue;
+
+            board[p] = board[cells[i]];
+            board[cells[i]] = 0;
+            ++compared;
+
+            if (snps_table_get(table, snps_rank(size, size, board)) ==
+                closer)
+                break;
+
+            board[cells[i]] = board[p];
+            board[p] = 0;
+        }
+
+        if (i == 4)
+            return NULL;
+
+        moves[length++] = directions[i];
+        p = cells[i];
+        distance = closer;
+    }
+
+    if (stats != NULL) {
+        stats->compared = compared;
+        stats->expanded = length;
+        stats->depth = length;
+    }
+
+    return snps_route_new_moves(game, moves, length);
+}
+
+/* allocate a table for a goal board without its distances */
+static snps_table_t *snps_table_new(unsigned rows, unsigned columns,
+    const unsigned char *goal)
+{
+    snps_table_t *table = g_slice_new(snps_table_t);
+    table->rows = rows;
+    table->columns = columns;
+    table->size = rows * columns;
+    table->depth = 0;
+    table->goal = g_memdup2(goal, table->size);
+    table->count = 1;
+    table->distances = NULL;
+    table->map = NULL;
+    table->map_length = 0;
+
+    for (unsigned i = 2; i <= table->size; ++i)
+        table->count *= i;
+
+    return table;
+}
+
+/* the offset of the distances within a table file */
+static gsize snps_table_offset(snps_table_t *table)
+{
+    return (sizeof(snps_table_header_t) + table->size + 7) & ~(gsize) 7;
+}
+
+/* the distance modulo 16 of the board with the given rank */
+static unsigned snps_table_get(const snps_table_t *table, guint64 rank)
+{
+    return (table->distances[rank / 2] >> (rank % 2 * 4)) & 0xf;
+}
+
+static void snps_table_set(snps_table_t *table, guint64 rank,
+    unsigned distance)
+{
+    unsigned shift = rank % 2 * 4;
+    unsigned char *byte = table->distances + rank / 2;
+
+    *byte = (*byte & ~(0xf << shift)) | (distance % 16) << shift;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
@@ -0,0 +1,746 @@
+#define _POSIX_C_SOURCE 200809L
+
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <glib.h>
+
+#include <libsnps/snps.h>
+
+/* the pattern database and the table of exact distances of a goal board,
+   built on first use and kept for all later requests */
+typedef struct {
+    GMutex lock;
+    /* a game from the goal board to itself, which keeps the shared
+       perimeter of the goal board alive between requests */
+    snps_game_t *game;
+    snps_pdb_t *pdb;
+    snps_table_t *table;
+    int perimeter_built;
+    int pdb_built;
+    int table_built;
+} server_goal_t;
+
+/* how the server runs, shared by all sessions */
+typedef struct {
+    unsigned threads;
+    unsigned requests;
+    unsigned perimeter;
+    size_t memory;
+    int unordered;
+    /* the directory keeping pattern databases and tables, NULL to keep
+       them in memory only */
+    const char *directory;
+    /* the requests waiting for a worker */
+    GAsyncQueue *work;
+    GMutex goals_lock;
+    GHashTable *goals;
+} server_t;
+
+/* the requests read from a stream and the results written to another one,
+   stdin and stdout or a connection to the socket */
+typedef struct {
+    server_t *server;
+    FILE *in;
+    FILE *out;
+    /* the requests to write, in the order they were read unless the output
+       is unordered */
+    GAsyncQueue *output;
+    GMutex lock;
+    GCond cond;
+    unsigned pending;
+} server_session_t;
+
+typedef enum {
+    SERVER_HEURISTIC_MANHATTAN,
+    SERVER_HEURISTIC_LINEAR,
+    SERVER_HEURISTIC_PDB,
+    SERVER_HEURISTIC_TABLE,
+} server_heuristic_t;
+
+/* a line of the protocol and its result */
+typedef struct {
+    server_session_t *session;
+    gchar *id;
+    const char *error;
+    snps_game_t *game;
+    snps_algorithm_t algorithm;
+    server_heuristic_t heuristic;
+    unsigned long long states;
+    double seconds;
+    snps_result_t result;
+    int done;
+} server_request_t;
+
+typedef struct {
+    server_t *server;
+    int fd;
+} server_connection_t;
+
+static const struct {
+    const char *name;
+    snps_algorithm_t algorithm;
+} algorithms[] = {
+    {"optimal", SNPS_ALGORITHM_OPTIMAL},
+    {"fast", SNPS_ALGORITHM_FAST},
+    {"ida", SNPS_ALGORITHM_IDA},
+    {"ida-parallel", SNPS_ALGORITHM_IDA_PARALLEL},
+    {"bidirectional", SNPS_ALGORITHM_BIDIRECTIONAL},
+    {"anytime", SNPS_ALGORITHM_ANYTIME},
+    {"fast-parallel", SNPS_ALGORITHM_FAST_PARALLEL},
+    {"decompose", SNPS_ALGORITHM_DECOMPOSE},
+};
+
+static const char *heuristics[] = {
+    "manhattan", "linear", "pdb", "table",
+};
+
+static const char *annotations[] = {
+    "walk", "manhattan", "linear", "length",
+};
+
+static const char *statuses[] = {
+    "solved", "unsolvable", "exhausted", "cancelled",
+};
+
+/* pushed to a queue to stop its reader */
+static server_request_t server_end;
+
+/* prototypes */
+static void server_session_run(server_t *server, FILE *in, FILE *out);
+static int server_listen(server_t *server, const char *path);
+static gpointer server_connection(gpointer data);
+static gpointer server_worker(gpointer data);
+static gpointer server_writer(gpointer data);
+static server_request_t *server_request_parse(server_session_t *session,
+    char *line, unsigned number);
+static int server_annotation(const char *key);
+static void server_request_solve(server_t *server, snps_solver_t *solver,
+    server_request_t *request);
+static void server_request_write(server_request_t *request, FILE *out);
+static void server_request_free(server_request_t *request);
+static server_goal_t *server_goal_get(server_t *server, snps_game_t *game);
+static snps_pdb_t *server_goal_pdb(server_t *server, server_goal_t *goal);
+static snps_table_t *server_goal_table(server_t *server,
+    server_goal_t *goal);
+static gchar *server_goal_filename(server_t *server, snps_game_t *game,
+    const char *suffix);
+static void server_goal_free(gpointer data);
+
+/* solve the games of a line protocol read from stdin or the connections to
+   a local socket on a pool of workers, which keep their memory and the
+   tables of every goal board between requests */
+int main(int argc, const char *argv[])
+{
+    const char *path = NULL;
+    server_t server = {
+        .threads = 0,
+        .requests = 0,
+        .perimeter = 0,
+        .memory = 1024,
+        .unordered = 0,
+        .directory = NULL,
+    };
+
+    /* usage: server [-t THREADS] [-q REQUESTS] [-p DEPTH] [-m MEGABYTES]
+       [-d DIRECTORY] [-o ordered|unordered] [-u SOCKET] */
+    for (int i = 1; i < argc; ++i) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (value == NULL || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+            fprintf(stderr, "Usage: %s [-t THREADS] [-q REQUESTS] "
+                "[-p DEPTH] [-m MEGABYTES] [-d DIRECTORY] "
+                "[-o ordered|unordered] [-u SOCKET]\n", argv[0]);
+            return 1;
+        }
+
+        switch (argv[i++][1]) {
+            case 't': server.threads = atoi(value); break;
+            case 'q': server.requests = atoi(value); break;
+            case 'p': server.perimeter = atoi(value); break;
+            case 'm': server.memory = strtoul(value, NULL, 10); break;
+            case 'd': server.directory = value; break;
+            case 'o': server.unordered = strcmp(value, "unordered") == 0;
+                break;
+            case 'u': path = value; break;
+            default:
+                fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+                return 1;
+        }
+    }
+
+    if (server.threads == 0)
+        server.threads = g_get_num_processors();
+    /* enough requests in flight to keep every worker busy while the
+       results of the others are written */
+    if (server.requests == 0)
+        server.requests = 4 * server.threads;
+
+    server.work = g_async_queue_new();
+    server.goals = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        server_goal_free);
+    g_mutex_init(&server.goals_lock);
+
+    GThread **workers = g_new(GThread *, server.threads);
+    for (int i = 0; i < server.threads; ++i)
+        workers[i] = g_thread_new("snps-worker", server_worker, &server);
+
+    int status = 0;
+
+    if (path == NULL) {
+        server_session_run(&server, stdin, stdout);
+    } else if (server_listen(&server, path) != 0) {
+        fprintf(stderr, "Unable to listen on %s\n", path);
+        status = 1;
+    }
+
+    for (int i = 0; i < server.threads; ++i)
+        g_async_queue_push(server.work, &server_end);
+    for (int i = 0; i < server.threads; ++i)
+        g_thread_join(workers[i]);
+
+    g_free(workers);
+    g_hash_table_destroy(server.goals);
+    g_mutex_clear(&server.goals_lock);
+    g_async_queue_unref(server.work);
+
+    return status;
+}
+
+/* read requests until the end of a stream, their games are parsed here and
+   solved by the workers while a writer thread writes the results */
+static void server_session_run(server_t *server, FILE *in, FILE *out)
+{
+    server_session_t session = {
+        .server = server,
+        .in = in,
+        .out = out,
+        .output = g_async_queue_new(),
+        .pending = 0,
+    };
+    char *line = NULL;
+    size_t capacity = 0;
+    unsigned number = 0;
+
+    g_mutex_init(&session.lock);
+    g_cond_init(&session.cond);
+
+    GThread *writer = g_thread_new("snps-writer", server_writer, &session);
+
+    while (getline(&line, &capacity, in) != -1) {
+        server_request_t *request = server_request_parse(&session, line,
+            ++number);
+
+        if (request == NULL)
+            continue;
+
+        /* bound the requests in flight, a slow one at the head of ordered
+           output holds back all later results */
+        g_mutex_lock(&session.lock);
+        while (session.pending >= server->requests)
+            g_cond_wait(&session.cond, &session.lock);
+        ++session.pending;
+        g_mutex_unlock(&session.lock);
+
+        if (request->error != NULL)
+            request->done = 1;
+        if (!server->unordered || request->done)
+            g_async_queue_push(session.output, request);
+        if (!request->done)
+            g_async_queue_push(server->work, request);
+    }
+
+    free(line);
+
+    g_mutex_lock(&session.lock);
+    while (session.pending > 0)
+        g_cond_wait(&session.cond, &session.lock);
+    g_mutex_unlock(&session.lock);
+
+    g_async_queue_push(session.output, &server_end);
+    g_thread_join(writer);
+
+    g_async_queue_unref(session.output);
+    g_cond_clear(&session.cond);
+    g_mutex_clear(&session.lock);
+}
+
+/* accept connections to a local socket and run a session for each of them
+   on its own thread, it only returns if the socket is unusable */
+static int server_listen(server_t *server, const char *path)
+{
+    struct sockaddr_un address;
+    int fd;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+        return -1;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+        return -1;
+
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(fd, 16) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    /* a client closing its connection early must not end the server */
+    signal(SIGPIPE, SIG_IGN);
+
+    while (42) {
+        int client = accept(fd, NULL, NULL);
+
+        if (client < 0)
+            continue;
+
+        server_connection_t *connection = g_slice_new(server_connection_t);
+        connection->server = server;
+        connection->fd = client;
+
+        g_thread_unref(g_thread_new("snps-connection", server_connection,
+            connection));
+    }
+
+    return 0;
+}
+
+/* run a session on a connection to the socket */
+static gpointer server_connection(gpointer data)
+{
+    server_connection_t *connection = (server_connection_t *) data;
+    FILE *in = fdopen(connection->fd, "r");
+    FILE *out = fdopen(dup(connection->fd), "w");
+
+    if (in != NULL && out != NULL)
+        server_session_run(connection->server, in, out);
+
+    if (in != NULL)
+        fclose(in);
+    else
+        close(connection->fd);
+    if (out != NULL)
+        fclose(out);
+
+    g_slice_free(server_connection_t, connection);
+
+    return NULL;
+}
+
+/* solve requests of any session until the server ends, every worker keeps
+   the memory of its searches in a solver context */
+static gpointer server_worker(gpointer data)
+{
+    server_t *server = (server_t *) data;
+    snps_solver_t *solver = snps_solver_new();
+
+    while (42) {
+        server_request_t *request = g_async_queue_pop(server->work);
+
+        if (request == &server_end)
+            break;
+
+        server_session_t *session = request->session;
+
+        server_request_solve(server, solver, request);
+
+        g_mutex_lock(&session->lock);
+        request->done = 1;
+        g_cond_broadcast(&session->cond);
+        g_mutex_unlock(&session->lock);
+
+        if (server->unordered)
+            g_async_queue_push(session->output, request);
+    }
+
+    snps_solver_free(solver);
+
+    return NULL;
+}
+
+/* write the results of a session, the stream is flushed whenever the
+   writer would have to wait for the next one */
+static gpointer server_writer(gpointer data)
+{
+    server_session_t *session = (server_session_t *) data;
+
+    while (42) {
+        server_request_t *request = g_async_queue_try_pop(session->output);
+
+        if (request == NULL) {
+            fflush(session->out);
+            request = g_async_queue_pop(session->output);
+        }
+
+        if (request == &server_end)
+            break;
+
+        g_mutex_lock(&session->lock);
+        if (!request->done) {
+            g_mutex_unlock(&session->lock);
+            fflush(session->out);
+            g_mutex_lock(&session->lock);
+        }
+        while (!request->done)
+            g_cond_wait(&session->cond, &session->lock);
+        g_mutex_unlock(&session->lock);
+
+        server_request_write(request, session->out);
+        server_request_free(request);
+
+        g_mutex_lock(&session->lock);
+        --session->pending;
+        g_cond_broadcast(&session->cond);
+        g_mutex_unlock(&session->lock);
+    }
+
+    fflush(session->out);
+
+    return NULL;
+}
+
+/* parse a line of whitespace separated key=value pairs, a token without a
+   key is the start board, returns NULL for empty lines and comments and a
+   request holding an error for malformed lines */
+static server_request_t *server_request_parse(server_session_t *session,
+    char *line, unsigned number)
+{
+    const char *from = NULL, *to = NULL, *size = "4x4";
+    unsigned rows, columns;
+    char *saved, *token;
+
+    line[strcspn(line, "#")] = '\0';
+    if ((token = strtok_r(line, " \t\r\n", &saved)) == NULL)
+        return NULL;
+
+    server_request_t *request = g_slice_new0(server_request_t);
+    request->session = session;
+    request->algorithm = SNPS_ALGORITHM_IDA;
+    request->heuristic = SERVER_HEURISTIC_MANHATTAN;
+
+    for (; token != NULL; token = strtok_r(NULL, " \t\r\n", &saved)) {
+        char *value = strchr(token, '=');
+
+        if (value == NULL) {
+            from = token;
+            continue;
+        }
+
+        *value++ = '\0';
+
+        if (strcmp(token, "id") == 0) {
+            g_free(request->id);
+            request->id = g_strdup(value);
+        } else if (strcmp(token, "size") == 0) {
+            size = value;
+        } else if (strcmp(token, "from") == 0) {
+            from = value;
+        } else if (strcmp(token, "to") == 0) {
+            to = value;
+        } else if (strcmp(token, "algorithm") == 0) {
+            int i = G_N_ELEMENTS(algorithms);
+            while (--i >= 0 && strcmp(algorithms[i].name, value) != 0);
+            if (i < 0)
+                request->error = "unknown algorithm";
+            else
+                request->algorithm = algorithms[i].algorithm;
+        } else if (strcmp(token, "heuristic") == 0) {
+            int i = G_N_ELEMENTS(heuristics);
+            while (--i >= 0 && strcmp(heuristics[i], value) != 0);
+            if (i < 0)
+                request->error = "unknown heuristic";
+            else
+                request->heuristic = i;
+        } else if (strcmp(token, "states") == 0) {
+            request->states = strtoull(value, NULL, 10);
+        } else if (strcmp(token, "seconds") == 0) {
+            request->seconds = strtod(value, NULL);
+        } else if (!server_annotation(token)) {
+            request->error = "unknown key";
+        }
+    }
+
+    if (request->id == NULL)
+        request->id = g_strdup_printf("%u", number);
+
+    if (request->error != NULL)
+        return request;
+
+    if (sscanf(size, "%ux%u", &rows, &columns) != 2 || rows == 0 ||
+        columns == 0 || rows * columns > SNPS_SIZE_MAX) {
+        request->error = "bad size";
+        return request;
+    }
+
+    unsigned char start[rows * columns], goal[rows * columns];
+
+    /* the ordered board with the blank last by default */
+    for (int i = 0; i < rows * columns; ++i)
+        goal[i] = (i + 1) % (rows * columns);
+
+    if (from == NULL || snps_board_parse(from, rows * columns, start) != 0)
+        request->error = "bad start board";
+    else if (to != NULL && snps_board_parse(to, rows * columns, goal) != 0)
+        request->error = "bad goal board";
+    else
+        request->game = snps_game_new(rows, columns, start, goal);
+
+    return request;
+}
+
+/* whether a key describes a game written by generate, which is ignored */
+static int server_annotation(const char *key)
+{
+    for (int i = 0; i < G_N_ELEMENTS(annotations); ++i)
+        if (strcmp(annotations[i], key) == 0)
+            return 1;
+
+    return 0;
+}
+
+/* prepare the game of a request using the kept tables of its goal board and
+   solve it within the limits of the request */
+static void server_request_solve(server_t *server, snps_solver_t *solver,
+    server_request_t *request)
+{
+    snps_game_t *game = request->game;
+    server_goal_t *goal = server_goal_get(server, game);
+
+    snps_game_set_memory_limit(game, server->memory * 1024 * 1024);
+    snps_game_set_perimeter(game, server->perimeter);
+
+    /* the solvers reject unsolvable games before looking at any table */
+    if (!snps_game_solvable(game))
+        request->heuristic = SERVER_HEURISTIC_MANHATTAN;
+
+    switch (request->heuristic) {
+        case SERVER_HEURISTIC_MANHATTAN:
+            break;
+        case SERVER_HEURISTIC_LINEAR:
+            snps_game_set_linear_conflict(game, 1);
+            break;
+        case SERVER_HEURISTIC_PDB:
+            snps_game_set_pdb(game, server_goal_pdb(server, goal));
+            if (game->pdb == NULL)
+                request->error = "no pattern database for this board";
+            break;
+        case SERVER_HEURISTIC_TABLE:
+            snps_game_set_table(game, server_goal_table(server, goal));
+            if (game->table == NULL)
+                request->error = "no table for this board";
+            break;
+    }
+
+    if (request->error != NULL)
+        return;
+
+    snps_options_t options = {
+        .algorithm = request->algorithm,
+        .states = request->states,
+        .deadline = request->seconds > 0 ?
+            snps_clock() + request->seconds : 0,
+        .solver = solver,
+    };
+
+    snps_solve_with(game, &options, &request->result);
+}
+
+/* write a result as id, status, number of moves, seconds, expanded states
+   and the moves of the blank, - if there are none */
+static void server_request_write(server_request_t *request, FILE *out)
+{
+    snps_route_t *route = request->result.route;
+    snps_stats_t *stats = &request->result.stats;
+
+    if (request->error != NULL) {
+        fprintf(out, "%s error %s\n", request->id, request->error);
+        return;
+    }
+
+    fprintf(out, "%s %s %u %.6f %u %s\n", request->id,
+        statuses[request->result.status], route != NULL ?
+        route->length - 1 : 0, stats->seconds, stats->expanded,
+        route != NULL && route->length > 1 ? (char *) route->moves : "-");
+}
+
+static void server_request_free(server_request_t *request)
+{
+    if (request->result.route != NULL)
+        snps_route_free(request->result.route);
+    if (request->game != NULL)
+        snps_game_free(request->game);
+    g_free(request->id);
+    g_slice_free(server_request_t, request);
+}
+
+/* look up the kept tables of the goal board of a game, the first game with
+   a goal board stays with them, its perimeter is built without blocking
+   the requests of other goal boards, later ones wait for it */
+static server_goal_t *server_goal_get(server_t *server, snps_game_t *game)
+{
+    GString *key = g_string_new(NULL);
+
+    g_string_append_printf(key, "%ux%u", game->rows, game->columns);
+    for (int i = 0; i < game->size; ++i)
+        g_string_append_printf(key, ",%u", game->to[i]);
+
+    g_mutex_lock(&server->goals_lock);
+
+    server_goal_t *goal = g_hash_table_lookup(server->goals, key->str);
+
+    if (goal == NULL) {
+        goal = g_slice_new0(server_goal_t);
+        g_mutex_init(&goal->lock);
+        goal->game = snps_game_new(game->rows, game->columns, game->to,
+            game->to);
+        g_hash_table_insert(server->goals, g_string_free(key, FALSE), goal);
+    } else {
+        g_string_free(key, TRUE);
+    }
+
+    g_mutex_unlock(&server->goals_lock);
+
+    g_mutex_lock(&goal->lock);
+    if (!goal->perimeter_built)
+        snps_game_set_perimeter(goal->game, server->perimeter);
+    goal->perimeter_built = 1;
+    g_mutex_unlock(&goal->lock);
+
+    return goal;
+}
+
+/* the pattern database of a goal board of up to 16 cells, loaded from the
+   directory or built and saved there by the first request using it, later
+   ones wait for it */
+static snps_pdb_t *server_goal_pdb(server_t *server, server_goal_t *goal)
+{
+    g_mutex_lock(&goal->lock);
+
+    if (!goal->pdb_built && goal->game->size <= 16) {
+        gchar *filename = server_goal_filename(server, goal->game, "pdb");
+
+        if (filename != NULL)
+            goal->pdb = snps_pdb_load(goal->game, filename);
+
+        if (goal->pdb == NULL) {
+            fprintf(stderr, "Building pattern database %s ...\n",
+                filename != NULL ? filename : "");
+            goal->pdb = snps_pdb_build(goal->game, NULL);
+            if (goal->pdb != NULL && filename != NULL &&
+                snps_pdb_save(goal->pdb, filename) != 0)
+                fprintf(stderr, "Unable to save %s\n", filename);
+        }
+
+        g_free(filename);
+    }
+
+    goal->pdb_built = 1;
+
+    g_mutex_unlock(&goal->lock);
+
+    return goal->pdb;
+}
+
+/* the table of exact distances of a goal board of up to 12 cells, kept like
+   the pattern databases */
+static snps_table_t *server_goal_table(server_t *server, server_goal_t *goal)
+{
+    g_mutex_lock(&goal->lock);
+
+    if (!goal->table_built && goal->game->size <= 12) {
+        gchar *filename = server_goal_filename(server, goal->game, "table");
+
+        if (filename != NULL)
+            goal->table = snps_table_load(goal->game, filename);
+
+        if (goal->table == NULL) {
+            fprintf(stderr, "Building table %s ...\n",
+                filename != NULL ? filename : "");
+            goal->table = snps_table_build(goal->game);
+            if (goal->table != NULL && filename != NULL &&
+                snps_table_save(goal->table, filename) != 0)
+                fprintf(stderr, "Unable to save %s\n", filename);
+        }
+
+        g_free(filename);
+    }
+
+    goal->table_built = 1;
+
+    g_mutex_unlock(&goal->lock);
+
+    return goal->table;
+}
+
+/* the file of a table of a goal board of up to 16 cells within the
+   directory, named by its shape and a hex digit per tile, NULL without a
+   directory */
+static gchar *server_goal_filename(server_t *server, snps_game_t *game,
+    const char *suffix)
+{
+    char tiles[17];
+
+    if (server->directory == NULL)
+        return NULL;
+
+    for (int i = 0; i < game->size; ++i)
+        tiles[i] = "0123456789ABCDEF"[game->to[i] & 15];
+    tiles[game->size] = '\0';
+
+    gchar *name = g_strdup_printf("%ux%u-%s.%s", game->rows, game->columns,
+        tiles, suffix);
+    gchar *filename = g_build_filename(server->directory, name, NULL);
+
+    g_free(name);
+
+    return filename;
+}
+
+static void server_goal_free(gpointer data)
+{
+    server_goal_t *goal = (server_goal_t *) data;
+
+    if (goal->pdb != NULL)
+        snps_pdb_free(goal->pdb);
+    if (goal->table != NULL)
+        snps_table_free(goal->table);
+    snps_game_free(goal->game);
+    g_mutex_clear(&goal->lock);
+    g_slice_free(server_goal_t, goal);
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */
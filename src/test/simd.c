@@ -0,0 +1,135 @@
+/**
+ * snps -- sliding number puzzles solver
+ *
+ * Copyright (C) 2011 Oliver Mader <b52@reaktor42.de>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <libsnps/snps_private.h>
+
+/* the shapes compared, those with a kernel of their own first */
+static const unsigned shapes[][2] = {
+    {3, 3}, {4, 4}, {5, 5}, {2, 3}, {3, 5}, {4, 6}, {6, 6},
+};
+
+static const char *simds[] = {
+    "scalar", "sse4", "avx2",
+};
+
+/* prototypes */
+static void simd_shuffle(GRand *rand, unsigned char *board, unsigned size);
+static unsigned simd_compare(snps_game_t *game, const unsigned char *board,
+    snps_simd_t simd);
+
+/* compare the board operations of every vector instruction set the
+   processor supports against the plain ones on random boards and goals,
+   exits with 1 if any of them differ */
+int main(int argc, const char *argv[])
+{
+    unsigned count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+    unsigned seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 42;
+    snps_simd_t best = snps_simd_limit(SNPS_SIMD_AVX2);
+    unsigned mismatches = 0;
+    GRand *rand = g_rand_new_with_seed(seed);
+
+    for (int i = 0; i < G_N_ELEMENTS(shapes); ++i) {
+        unsigned size = shapes[i][0] * shapes[i][1];
+        unsigned char from[size], to[size];
+
+        for (unsigned j = 0; j < count; ++j) {
+            simd_shuffle(rand, from, size);
+            simd_shuffle(rand, to, size);
+            snps_game_t *game = snps_game_new(shapes[i][0], shapes[i][1],
+                from, to);
+
+            for (snps_simd_t simd = SNPS_SIMD_SSE4; simd <= best; ++simd) {
+                unsigned differ = simd_compare(game, from, simd);
+
+                if (differ > 0)
+                    fprintf(stderr, "%ux%u board %u differs using %s\n",
+                        shapes[i][0], shapes[i][1], j, simds[simd]);
+                mismatches += differ;
+            }
+
+            snps_game_free(game);
+        }
+    }
+
+    printf("%u boards of %u shapes compared up to %s, %u differ\n",
+        count * (unsigned) G_N_ELEMENTS(shapes),
+        (unsigned) G_N_ELEMENTS(shapes), simds[best], mismatches);
+
+    g_rand_free(rand);
+
+    return mismatches > 0;
+}
+
+/* a random permutation of the tiles of a board */
+static void simd_shuffle(GRand *rand, unsigned char *board, unsigned size)
+{
+    for (unsigned i = 0; i < size; ++i)
+        board[i] = i;
+
+    for (unsigned i = size - 1; i > 0; --i) {
+        unsigned j = g_rand_int_range(rand, 0, i + 1);
+        unsigned char tile = board[i];
+        board[i] = board[j];
+        board[j] = tile;
+    }
+}
+
+/* 1 if packing, unpacking or the manhattan distance of a board differ
+   between the plain operations and those of the given instructions */
+static unsigned simd_compare(snps_game_t *game, const unsigned char *board,
+    snps_simd_t simd)
+{
+    snps_simd_limit(SNPS_SIMD_SCALAR);
+    const snps_simd_ops_t *scalar = snps_simd_ops;
+    snps_simd_limit(simd);
+    const snps_simd_ops_t *ops = snps_simd_ops;
+
+    if (ops->manhattan(game, board) != scalar->manhattan(game, board))
+        return 1;
+
+    /* only boards of up to 16 cells are packed into single words */
+    if (game->size > 16)
+        return 0;
+
+    unsigned char padded[16] = {0}, unpacked[16], expected[16];
+    memcpy(padded, board, game->size);
+    guint64 key = scalar->pack(padded);
+
+    if (ops->pack(padded) != key)
+        return 1;
+
+    ops->unpack(key, unpacked);
+    scalar->unpack(key, expected);
+
+    return memcmp(unpacked, expected, 16) != 0 ||
+        memcmp(unpacked, padded, game->size) != 0;
+}
+
+/* vim: set expandtab shiftwidth=4 softtabstop=4 textwidth=79: */